@@ -35,7 +35,7 @@ platform_get_os_timer() {
     return timer.QuadPart;
 #elif PLT_LINUX
     struct timeval timer;
-    gettimejofday(&timer, 0);
+    gettimeofday(&timer, 0);
     return platform_get_os_timer_freq() * (u64)timer.tv_sec + (u64)timer.tv_usec;
 #endif
 }
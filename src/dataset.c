@@ -0,0 +1,279 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 16:20:41 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#include "dataset.h"
+
+#define dataset_err(str) fprintf(stderr, "dataset error: " str "\n")
+
+/* NOTE(abid): A word at a time rather than FNV's byte at a time, the columns are tens of MB. A
+ * `size` that is not a multiple of 8 has its last word zero-padded, so only the last update of a
+ * column may have one. */
+#define DATASET_CHECKSUM_SEED 0xcbf29ce484222325ULL
+internal inline u64
+dataset_checksum_update(u64 state, void *data, u64 size) {
+    u8 *bytes = (u8 *)data;
+    for(u64 offset = 0; offset < size; offset += sizeof(u64)) {
+        u64 word = 0;
+        memcpy(&word, bytes + offset, (size - offset < sizeof(u64)) ? size - offset : sizeof(u64));
+        state = (state ^ word) * 0x9e3779b97f4a7c15ULL;
+        state ^= state >> 32;
+    }
+
+    return state;
+}
+
+/* NOTE(abid): Column states folded in column order, a missing column counts as its seed. */
+internal u64
+dataset_checksum_finish(u64 *column_states) {
+    u64 checksum = DATASET_CHECKSUM_SEED;
+    for(u32 column = 0; column < dataset_column_count; ++column) {
+        checksum = (checksum ^ column_states[column]) * 0x100000001b3ULL;
+    }
+
+    checksum ^= checksum >> 33;
+    checksum *= 0xff51afd7ed558ccdULL;
+    checksum ^= checksum >> 33;
+    return checksum;
+}
+
+internal inline u64
+dataset_align(u64 offset) { return (offset + DATASET_ALIGNMENT - 1) & ~(u64)(DATASET_ALIGNMENT - 1); }
+
+/* NOTE(abid): Bytes per value of `column`. */
+internal inline u64
+dataset_value_size(u32 flags, u32 column) {
+    return ((flags & dataset_is_q32) && column != dataset_column_reference) ? sizeof(i32) : sizeof(f64);
+}
+
+/* NOTE(abid): Where every column goes for `pair_count` pairs, right after the header. */
+internal dataset_header
+dataset_header_make(u64 pair_count, u32 flags) {
+    dataset_header header = {
+        .magic = DATASET_MAGIC,
+        .version = DATASET_VERSION,
+        .header_size = sizeof(dataset_header),
+        .pair_count = pair_count,
+        .flags = flags,
+        .column_alignment = DATASET_ALIGNMENT,
+    };
+
+    u64 offset = dataset_align(sizeof(dataset_header));
+    for(u32 column = 0; column < dataset_column_count; ++column) {
+        if(column == dataset_column_reference && !(flags & dataset_has_reference)) continue;
+        header.column_offsets[column] = offset;
+        offset = dataset_align(offset + pair_count*dataset_value_size(flags, column));
+    }
+
+    return header;
+}
+
+internal bool
+dataset_file_seek(FILE *handle, u64 offset) {
+#ifdef PLT_WIN
+    return _fseeki64(handle, (i64)offset, SEEK_SET) == 0;
+#elif PLT_LINUX
+    return fseeko(handle, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+/* NOTE(abid): `flags` are `dataset_flags`, pairs are pushed as f64 either way. */
+internal bool
+dataset_writer_begin(dataset_writer *writer, char *filename, u64 pair_count, u32 flags) {
+    *writer = (dataset_writer){0};
+    writer->header = dataset_header_make(pair_count, flags);
+    writer->column_count = (flags & dataset_has_reference) ? dataset_column_count : dataset_column_reference;
+    writer->handle = fopen(filename, "wb");
+    if(writer->handle == NULL) return false;
+
+    f64 *staging = malloc(writer->column_count * DATASET_WRITER_BATCH_COUNT * sizeof(f64));
+    assert(staging, "cannot allocate dataset staging buffers.");
+    if(flags & dataset_is_q32) {
+        writer->quantized = malloc(DATASET_WRITER_BATCH_COUNT * sizeof(i32));
+        assert(writer->quantized, "cannot allocate dataset staging buffers.");
+    }
+    for(u32 column = 0; column < dataset_column_count; ++column) {
+        writer->column_states[column] = DATASET_CHECKSUM_SEED;
+        if(column < writer->column_count) writer->columns[column] = staging + column*DATASET_WRITER_BATCH_COUNT;
+    }
+
+    writer->is_valid = true;
+    return true;
+}
+
+internal void
+dataset_writer_flush(dataset_writer *writer) {
+    if(writer->batch_count == 0) return;
+
+    for(u32 column = 0; column < writer->column_count; ++column) {
+        void *values = writer->columns[column];
+        u64 value_size = dataset_value_size(writer->header.flags, column);
+        if(value_size == sizeof(i32)) {
+            for(u64 idx = 0; idx < writer->batch_count; ++idx) {
+                writer->quantized[idx] = q32_from_degrees(writer->columns[column][idx]);
+            }
+            values = writer->quantized;
+        }
+
+        writer->column_states[column] = dataset_checksum_update(writer->column_states[column], values,
+                                                                writer->batch_count*value_size);
+        u64 offset = writer->header.column_offsets[column] + writer->written_count*value_size;
+        writer->is_valid = writer->is_valid && dataset_file_seek(writer->handle, offset) &&
+                           fwrite(values, value_size, writer->batch_count, writer->handle) == writer->batch_count;
+    }
+
+    writer->written_count += writer->batch_count;
+    writer->batch_count = 0;
+}
+
+internal inline void
+dataset_writer_push(dataset_writer *writer, f64 x0, f64 y0, f64 x1, f64 y1, f64 reference) {
+    assert(writer->written_count + writer->batch_count < writer->header.pair_count,
+           "more pairs pushed than the dataset was started with.");
+    u64 idx = writer->batch_count;
+    writer->columns[dataset_column_x0][idx] = x0;
+    writer->columns[dataset_column_y0][idx] = y0;
+    writer->columns[dataset_column_x1][idx] = x1;
+    writer->columns[dataset_column_y1][idx] = y1;
+    if(writer->column_count > dataset_column_reference) writer->columns[dataset_column_reference][idx] = reference;
+
+    if(++writer->batch_count == DATASET_WRITER_BATCH_COUNT) dataset_writer_flush(writer);
+}
+
+/* NOTE(abid): The header goes in last, with the checksum, so a file cut short by a crash has none
+ * and is refused on open. The gaps between columns are never written, they read back as zeros. */
+internal bool
+dataset_writer_end(dataset_writer *writer) {
+    dataset_writer_flush(writer);
+    assert(writer->written_count == writer->header.pair_count, "fewer pairs pushed than the dataset was started with.");
+
+    writer->header.checksum = dataset_checksum_finish(writer->column_states);
+    bool result = writer->is_valid && dataset_file_seek(writer->handle, 0) &&
+                  fwrite(&writer->header, sizeof(dataset_header), 1, writer->handle) == 1;
+
+    result = (fclose(writer->handle) == 0) && result;
+    free(writer->columns[0]);
+    free(writer->quantized);
+    *writer = (dataset_writer){0};
+
+    return result;
+}
+
+/* NOTE(abid): A whole `pair_soa` at once, `reference` may be NULL. */
+internal bool
+dataset_write(char *filename, pair_soa *pairs, f64 *reference, bool is_q32) {
+    u32 flags = (reference ? dataset_has_reference : 0) | (is_q32 ? dataset_is_q32 : 0);
+    dataset_writer writer;
+    if(!dataset_writer_begin(&writer, filename, pairs->count, flags)) return false;
+    for(u64 idx = 0; idx < pairs->count; ++idx) {
+        dataset_writer_push(&writer, pairs->x0[idx], pairs->y0[idx], pairs->x1[idx], pairs->y1[idx],
+                            reference ? reference[idx] : 0.0);
+    }
+
+    return dataset_writer_end(&writer);
+}
+
+internal bool
+dataset_header_is_valid(dataset_header *header, usize file_size) {
+    if(header->magic != DATASET_MAGIC) { dataset_err("not a pair dataset."); return false; }
+    if(header->version != DATASET_VERSION) { dataset_err("unsupported dataset version."); return false; }
+    if(header->header_size != sizeof(dataset_header) || header->column_alignment != DATASET_ALIGNMENT) {
+        dataset_err("unexpected header layout.");
+        return false;
+    }
+    if(header->flags & ~(u32)dataset_flags_all) { dataset_err("unknown dataset flags."); return false; }
+    if(header->pair_count > file_size / sizeof(i32)) { dataset_err("pair count larger than the file."); return false; }
+
+    for(u32 column = 0; column < dataset_column_count; ++column) {
+        u64 offset = header->column_offsets[column];
+        u64 column_size = header->pair_count * dataset_value_size(header->flags, column);
+        bool is_present = (column != dataset_column_reference) || (header->flags & dataset_has_reference);
+        if(!is_present) {
+            if(offset != 0) { dataset_err("offset for a missing column."); return false; }
+            continue;
+        }
+        /* NOTE(abid): The columns of an empty dataset are never written, so may start past the end. */
+        if(offset < sizeof(dataset_header) || (offset & (DATASET_ALIGNMENT - 1)) ||
+           (column_size && (offset > file_size || column_size > file_size - offset))) {
+            dataset_err("column out of the file or misaligned.");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* NOTE(abid): Maps `filename` and points `result` at its columns, nothing is read until used. The
+ * mapping is page aligned and so are the columns to DATASET_ALIGNMENT, which keeps the SIMD loads
+ * aligned as well. */
+internal bool
+__dataset_open_impl(char *filename, dataset *result, dataset_open_opt opt) {
+    *result = (dataset){0};
+    if(!platform_file_map(filename, opt.map_flags, &result->mapping)) return false;
+    if(result->mapping.size < sizeof(dataset_header)) {
+        dataset_err("file too small for a dataset header.");
+        platform_file_unmap(&result->mapping);
+        return false;
+    }
+
+    dataset_header *header = (dataset_header *)result->mapping.data;
+    if(!dataset_header_is_valid(header, result->mapping.size)) {
+        platform_file_unmap(&result->mapping);
+        return false;
+    }
+
+    char *base = result->mapping.data;
+    result->header = header;
+    if(header->flags & dataset_is_q32) {
+        result->pairs_q32 = (pair_soa_q32) {
+            .count = header->pair_count,
+            .x0 = (i32 *)(base + header->column_offsets[dataset_column_x0]),
+            .y0 = (i32 *)(base + header->column_offsets[dataset_column_y0]),
+            .x1 = (i32 *)(base + header->column_offsets[dataset_column_x1]),
+            .y1 = (i32 *)(base + header->column_offsets[dataset_column_y1]),
+        };
+    } else {
+        result->pairs = (pair_soa) {
+            .count = header->pair_count,
+            .x0 = (f64 *)(base + header->column_offsets[dataset_column_x0]),
+            .y0 = (f64 *)(base + header->column_offsets[dataset_column_y0]),
+            .x1 = (f64 *)(base + header->column_offsets[dataset_column_x1]),
+            .y1 = (f64 *)(base + header->column_offsets[dataset_column_y1]),
+        };
+    }
+    if(header->flags & dataset_has_reference) {
+        result->reference = (f64 *)(base + header->column_offsets[dataset_column_reference]);
+    }
+
+    if(opt.is_verify) {
+        u64 column_states[dataset_column_count];
+        for(u32 column = 0; column < dataset_column_count; ++column) {
+            column_states[column] = DATASET_CHECKSUM_SEED;
+            if(header->column_offsets[column]) {
+                column_states[column] = dataset_checksum_update(DATASET_CHECKSUM_SEED,
+                                                                base + header->column_offsets[column],
+                                                                header->pair_count*dataset_value_size(header->flags, column));
+            }
+        }
+        if(dataset_checksum_finish(column_states) != header->checksum) {
+            dataset_err("checksum mismatch.");
+            platform_file_unmap(&result->mapping);
+            *result = (dataset){0};
+            return false;
+        }
+    }
+
+    return true;
+}
+#define dataset_open(filename, dataset, ...) \
+    __dataset_open_impl(filename, dataset, (dataset_open_opt){ dataset_open_opt_default, __VA_ARGS__ })
+
+internal void
+dataset_close(dataset *data) {
+    platform_file_unmap(&data->mapping);
+    *data = (dataset){0};
+}
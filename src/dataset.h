@@ -0,0 +1,86 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 16:20:41 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+/* NOTE(abid): The loader hands out a `pair_soa`, and the generator (before kernel.c) writes these. */
+#include "kernel.h"
+
+#if !defined(DATASET_H)
+
+/* NOTE(abid): Binary pair dataset ("HVPAIRS\0" little-endian). A `dataset_header`, then one column
+ * of `pair_count` values per `dataset_column`, each starting at a multiple of DATASET_ALIGNMENT with
+ * zeros in between. Coordinates are f64, or i32 as in `pair_soa_q32` with `dataset_is_q32`, the
+ * reference is always f64. The columns are what the batch kernels take, so a mapped file is used as
+ * it is, with no parsing and no copy. Little-endian only, like every machine this runs on. */
+#define DATASET_MAGIC 0x0053524941505648ULL
+#define DATASET_VERSION 1
+#define DATASET_ALIGNMENT 64
+#define DATASET_EXTENSION ".hpd"
+
+typedef enum {
+    dataset_column_x0,
+    dataset_column_y0,
+    dataset_column_x1,
+    dataset_column_y1,
+    dataset_column_reference, // Distance the generator computed, only with `dataset_has_reference`.
+
+    dataset_column_count
+} dataset_column;
+
+typedef enum {
+    dataset_has_reference = 1 << 0,
+    dataset_is_q32 = 1 << 1, // Coordinate columns are quantized, see `pair_soa_q32`.
+
+    dataset_flags_all = dataset_has_reference | dataset_is_q32
+} dataset_flags;
+
+typedef struct {
+    u64 magic;
+    u32 version;
+    u32 header_size;
+    u64 pair_count;
+    u32 flags;
+    u32 column_alignment;
+    u64 column_offsets[dataset_column_count]; // From the start of the file, 0 for a missing column.
+    /* NOTE(abid): Over the columns only, see `dataset_checksum_finish`. The header is checked
+     * field by field on open instead. */
+    u64 checksum;
+} dataset_header;
+
+/* NOTE(abid): Pairs staged per column before they are written out. */
+#define DATASET_WRITER_BATCH_COUNT 65536
+
+/* NOTE(abid): Writes a dataset one pair at a time. The pair count is fixed up front so every column
+ * has its place in the file from the start, a full batch goes to each column in turn. */
+typedef struct {
+    FILE *handle;
+    dataset_header header;
+    u32 column_count;
+    f64 *columns[dataset_column_count];
+    i32 *quantized; // The column being written, with `dataset_is_q32`.
+    u64 column_states[dataset_column_count]; // Running checksum of each column.
+    u64 batch_count;
+    u64 written_count;
+    bool is_valid; // Cleared by any failed write.
+} dataset_writer;
+
+/* NOTE(abid): A mapped dataset, the arrays of `pairs` (or `pairs_q32` with `dataset_is_q32`, the
+ * other one is empty) and `reference` point into `mapping`. */
+typedef struct {
+    platform_file_mapping mapping;
+    dataset_header *header;
+    pair_soa pairs;
+    pair_soa_q32 pairs_q32;
+    f64 *reference; // NULL when the file has none.
+} dataset;
+
+/* NOTE(abid): Verifying reads every page of the columns, which is most of what a load costs. */
+typedef struct { bool is_verify; u32 map_flags; } dataset_open_opt;
+#define dataset_open_opt_default .is_verify = false, .map_flags = file_map_sequential
+
+#define DATASET_H
+#endif
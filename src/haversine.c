@@ -6,6 +6,10 @@
     |                                                                                  |
     +======================================| Copyright © Sayed Abid Hashimi |==========+  */
 
+#include "haversine.h"
+/* NOTE(abid): For SIMD_ALIGNMENT, the chunks are handed to the kernels too. */
+#include "simd.h"
+
 /* NOTE(abid): EarthRadius is generally expected to be 6372.8 */
 #define EARTH_RADIUS 6372.8
 internal f64
@@ -28,151 +32,296 @@ haversine(f64 x0, f64 y0, f64 x1, f64 y1, f64 earth_radius) {
     return result;
 }
 
+/* NOTE(abid): `expected_size` > 0 preallocates that much. */
+internal bool
+file_writer_open(file_writer *writer, char *filename, u64 expected_size) {
+    *writer = (file_writer){0};
+    if(!platform_file_create(filename, &writer->file)) return false;
+
+    writer->capacity = FILE_WRITER_CAPACITY;
+    writer->buffer = (char *)platform_allocate(writer->capacity);
+    if(expected_size) writer->is_preallocated = platform_file_preallocate(&writer->file, expected_size);
+    writer->is_valid = true;
+
+    return true;
+}
+
 internal void
-offload_to_buffer(mem_arena *json_arena, mem_arena *result_arena, f64 y0, f64 y1, f64 x0, f64 x1,
-                  bool is_last, char *json_filename, char *f64_filename) {
-    u64 suffix_len = 3; /* NOTE(abid): Length of "\n]}" */
-
-    /* NOTE(abid): We will be overestimating our memory usage since we assume each number's
-     *             length to be 3 + FloatPrecision, which will not always be true. */
-    u32 precision = 20;
-    i32 num_chars_per_pair = 1 + 2 + 4*4 + 4 + 3 + 1 + 1 + 4*(4 + 1 + precision);
-    snprintf(arena_current(json_arena), json_arena->size - json_arena->used,
-              "\t{\"x0\":%.*f, \"y0\":%.*f, \"x1\":%.*f, \"y1\":%.*f}",
-              precision, x0, precision, y0, precision, x1, precision, y1);
-    arena_advance(json_arena, strlen(arena_current(json_arena)), char);
-
-    if(is_last) {
-        snprintf(arena_current(json_arena), suffix_len+1, /* suffix = */ "\n]}");
-        arena_advance(json_arena, suffix_len, char);
-    } else {
-        snprintf(arena_current(json_arena), 3, ",\n");
-        arena_advance(json_arena, 2, char);
+file_writer_flush(file_writer *writer, bool is_final) {
+    usize size = is_final ? writer->used : (writer->used & ~(usize)(FILE_WRITER_ALIGNMENT - 1));
+    if(size == 0) return;
+
+    u64 os_start = platform_get_os_timer();
+    writer->is_valid = writer->is_valid && platform_file_write(&writer->file, writer->buffer, size);
+    writer->write_time += platform_get_os_timer() - os_start;
+    writer->written_bytes += size;
+
+    memmove(writer->buffer, writer->buffer + size, writer->used - size);
+    writer->used -= size;
+}
+
+/* NOTE(abid): Room for `size` bytes at the end of the buffer, `file_writer_advance` over what was
+ * used of it. `size` can be up to the capacity less the alignment. */
+internal inline char *
+file_writer_reserve(file_writer *writer, usize size) {
+    if(writer->capacity - writer->used < size) file_writer_flush(writer, false);
+    assert(writer->capacity - writer->used >= size, "reservation larger than the writer can hold.");
+    return writer->buffer + writer->used;
+}
+
+internal inline void
+file_writer_advance(file_writer *writer, usize size) { writer->used += size; }
+
+internal inline void
+file_writer_write(file_writer *writer, void *data, usize size) {
+    memcpy(file_writer_reserve(writer, size), data, size);
+    file_writer_advance(writer, size);
+}
+
+/* NOTE(abid): Writes what is left and closes, `written_bytes` and `write_time` stay readable. */
+internal bool
+file_writer_close(file_writer *writer) {
+    file_writer_flush(writer, true);
+    bool result = writer->is_valid;
+    if(writer->is_preallocated) result = platform_file_truncate(&writer->file, writer->written_bytes) && result;
+    result = platform_file_close(&writer->file) && result;
+    platform_free(writer->buffer, writer->capacity);
+    writer->buffer = NULL;
+
+    return result;
+}
+
+/* NOTE(abid): `filename` with `extension` appended. */
+internal char *
+generate_filename(char *filename, char *extension, mem_arena *arena) {
+    usize filename_len = strlen(filename);
+    usize extension_len = strlen(extension);
+    char *result = push_size(filename_len + extension_len + 1, arena);
+    memcpy(result, filename, filename_len);
+    memcpy(result + filename_len, extension, extension_len + 1);
+    return result;
+}
+
+#define generate_put_literal(dest, literal) (memcpy(dest, literal, sizeof(literal) - 1), (dest) += sizeof(literal) - 1)
+
+/* NOTE(abid): Formats one pair into `dest`, returns the bytes written. */
+internal usize
+generate_format_pair(char *dest, f64 x0, f64 y0, f64 x1, f64 y1, bool is_first) {
+    char *start = dest;
+    if(!is_first) generate_put_literal(dest, ",\n");
+    generate_put_literal(dest, "\t{\"x0\":");
+    dest += format_f64_fixed(dest, x0, GENERATE_JSON_PRECISION);
+    generate_put_literal(dest, ", \"y0\":");
+    dest += format_f64_fixed(dest, y0, GENERATE_JSON_PRECISION);
+    generate_put_literal(dest, ", \"x1\":");
+    dest += format_f64_fixed(dest, x1, GENERATE_JSON_PRECISION);
+    generate_put_literal(dest, ", \"y1\":");
+    dest += format_f64_fixed(dest, y1, GENERATE_JSON_PRECISION);
+    generate_put_literal(dest, "}");
+
+    return (usize)(dest - start);
+}
+
+/* NOTE(abid): Chunk `chunk_idx` into `chunk`, from its own substream. Each coordinate is drawn for
+ * the whole chunk at once, lat1, lat2, lon1, lon2, as [0, 1) straight into the pair arrays, and then
+ * scaled to its cluster in place. */
+internal void
+generate_chunk_fill(generate_job *job, u64 chunk_idx, generate_chunk *chunk) {
+    rand_lanes lanes = rand_lanes_create(job->seed, 2*chunk_idx + 1);
+    chunk->first_pair = chunk_idx * GENERATE_CHUNK_PAIRS;
+    chunk->pairs.count = job->number_pairs - chunk->first_pair;
+    if(chunk->pairs.count > GENERATE_CHUNK_PAIRS) chunk->pairs.count = GENERATE_CHUNK_PAIRS;
+    chunk->json_size = 0;
+
+    u64 count = chunk->pairs.count;
+    rand_lanes_fill_unit(&lanes, chunk->pairs.y0, count);
+    rand_lanes_fill_unit(&lanes, chunk->pairs.y1, count);
+    rand_lanes_fill_unit(&lanes, chunk->pairs.x0, count);
+    rand_lanes_fill_unit(&lanes, chunk->pairs.x1, count);
+
+    for(u64 idx = 0; idx < count; ++idx) {
+        u64 pair_idx = chunk->first_pair + idx;
+        f64 lat1, lat2, lon1, lon2;
+        if(job->clusters) {
+            /* NOTE(abid): The remainder all goes in the last cluster, however many pairs it is. */
+            u64 cluster_idx = job->pairs_per_cluster ? pair_idx / job->pairs_per_cluster : job->cluster_count - 1;
+            if(cluster_idx > job->cluster_count - 1) cluster_idx = job->cluster_count - 1;
+            generate_cluster *cluster = job->clusters + cluster_idx;
+            lat1 = cluster->lat1_start + chunk->pairs.y0[idx]*cluster->lat1_size;
+            lat2 = cluster->lat2_start + chunk->pairs.y1[idx]*cluster->lat2_size;
+            lon1 = cluster->lon1_start + chunk->pairs.x0[idx]*cluster->lon1_size;
+            lon2 = cluster->lon2_start + chunk->pairs.x1[idx]*cluster->lon2_size;
+        } else {
+            lat1 = -90. + chunk->pairs.y0[idx]*180.;
+            lat2 = -90. + chunk->pairs.y1[idx]*180.;
+            lon1 = -180. + chunk->pairs.x0[idx]*360.;
+            lon2 = -180. + chunk->pairs.x1[idx]*360.;
+        }
+
+        chunk->pairs.x0[idx] = lon1;
+        chunk->pairs.y0[idx] = lat1;
+        chunk->pairs.x1[idx] = lon2;
+        chunk->pairs.y1[idx] = lat2;
+        if(job->is_reference) chunk->distances[idx] = haversine(lon1, lat1, lon2, lat2, EARTH_RADIUS);
+        if(job->is_json) {
+            chunk->json_size += generate_format_pair(chunk->json + chunk->json_size, lon1, lat1, lon2, lat2,
+                                                     pair_idx == 0);
+        }
+    }
+    /* NOTE(abid): Sentinel, for parsing the chunk where it is. */
+    if(job->is_json) chunk->json[chunk->json_size] = '\0';
+}
+
+internal void
+generate_chunk_job_fn(void *data, u64 first, u64 count, u32 worker_idx) {
+    generate_job *job = (generate_job *)data;
+    (void)worker_idx;
+    for(u64 idx = first; idx < first + count; ++idx) {
+        generate_chunk_fill(job, job->first_chunk + idx, job->chunks + idx);
+    }
+}
+
+/* NOTE(abid): Everything that has to see the pairs in order, on the calling thread. */
+internal void
+generate_chunk_emit(generate_output *output, generate_chunk *chunk, stat_f64 *haversine_stat) {
+    pair_soa *pairs = &chunk->pairs;
+    for(u64 idx = 0; idx < pairs->count; ++idx) {
+        stat_f64_accumulate(pairs->y0[idx], haversine_stat);
+        stat_f64_accumulate(pairs->y1[idx], haversine_stat);
+        stat_f64_accumulate(pairs->x0[idx], haversine_stat);
+        stat_f64_accumulate(pairs->x1[idx], haversine_stat);
     }
 
-    /* NOTE(abid): Save the result to buffer and .f64 file. */
-    f64 *dest = arena_current(result_arena);
-    *dest = haversine(x0, y0, x1, y1, EARTH_RADIUS);
-    arena_advance(result_arena, 1, f64);
-
-    /* NOTE(abid): If end of buffer, or we are out of memory for next round, then flush. */
-    if(result_arena->used >= result_arena->size || is_last) {
-        FILE *file_handle = fopen(f64_filename, "ab");
-        assert(file_handle, "cannot save to .f64 file.");
-        fwrite(result_arena->ptr, sizeof(f64), result_arena->used/sizeof(f64), file_handle);
-        fclose(file_handle);
-        result_arena->used = 0;
+    if(output->is_json) {
+        file_writer_write(&output->json, chunk->json, chunk->json_size);
+        file_writer_write(&output->f64, chunk->distances, pairs->count*sizeof(f64));
     }
+    if(output->is_dataset) {
+        for(u64 idx = 0; idx < pairs->count; ++idx) {
+            dataset_writer_push(&output->dataset, pairs->x0[idx], pairs->y0[idx], pairs->x1[idx], pairs->y1[idx],
+                                chunk->distances[idx]);
+        }
+    }
+}
+
+/* NOTE(abid): A job of `number_pairs` from the next value of the global random state, with its
+ * clusters made, `chunks` is left to the caller. */
+internal generate_job
+generate_job_make(u64 number_pairs, u64 num_clusters, bool is_json, mem_arena *arena) {
+    generate_job job = {
+        .seed = RandU64(),
+        .number_pairs = number_pairs,
+        .is_json = is_json,
+    };
+    if(num_clusters) {
+        job.pairs_per_cluster = number_pairs / num_clusters;
+        job.cluster_count = num_clusters + ((number_pairs % num_clusters) ? 1 : 0);
+        job.clusters = push_array_aligned(generate_cluster, job.cluster_count, SIMD_ALIGNMENT, arena);
+        for(u64 cluster_idx = 0; cluster_idx < job.cluster_count; ++cluster_idx) {
+            /* NOTE(abid): A cluster is one round of the lanes, a draw per lane. */
+            rand_lanes lanes = rand_lanes_create(job.seed, 2*cluster_idx);
+            f64 units[RAND_LANE_COUNT];
+            rand_lanes_fill_unit(&lanes, units, RAND_LANE_COUNT);
+
+            generate_cluster *cluster = job.clusters + cluster_idx;
+            cluster->lat1_size = 10. + units[0]*90.;
+            cluster->lon1_size = 20. + units[1]*180.;
+            cluster->lat1_start = -90. + units[2]*(180. - cluster->lat1_size);
+            cluster->lon1_start = -180. + units[3]*(360. - cluster->lon1_size);
 
-    /* NOTE(abid): If end of buffer, or we are out of memory for next round, then flush. */
-    if((json_arena->used + num_chars_per_pair + suffix_len + 1 >= json_arena->size) || is_last) {
-        FILE *file_handle = fopen(json_filename, "ab");
-        assert(file_handle, "cannot save to .json file.");
-        fputs(json_arena->ptr, file_handle);
-        fclose(file_handle);
-        json_arena->used = 0;
+            cluster->lat2_size = 10. + units[4]*90.;
+            cluster->lon2_size = 20. + units[5]*180.;
+            cluster->lat2_start = -90. + units[6]*(180. - cluster->lat2_size);
+            cluster->lon2_start = -180. + units[7]*(360. - cluster->lon2_size);
+        }
     }
+
+    return job;
+}
+
+/* NOTE(abid): Room for GENERATE_CHUNK_PAIRS pairs. */
+internal void
+generate_chunk_init(generate_chunk *chunk, bool is_json, mem_arena *arena) {
+    *chunk = (generate_chunk){0};
+    chunk->pairs = (pair_soa) {
+        .x0 = push_array_aligned(f64, GENERATE_CHUNK_PAIRS, SIMD_ALIGNMENT, arena),
+        .y0 = push_array_aligned(f64, GENERATE_CHUNK_PAIRS, SIMD_ALIGNMENT, arena),
+        .x1 = push_array_aligned(f64, GENERATE_CHUNK_PAIRS, SIMD_ALIGNMENT, arena),
+        .y1 = push_array_aligned(f64, GENERATE_CHUNK_PAIRS, SIMD_ALIGNMENT, arena),
+    };
+    chunk->distances = push_array_aligned(f64, GENERATE_CHUNK_PAIRS, SIMD_ALIGNMENT, arena);
+    /* NOTE(abid): Generated coordinates are within +-180 degrees, GENERATE_JSON_PAIR_SIZE holds. */
+    if(is_json) chunk->json = push_size(GENERATE_CHUNK_PAIRS*GENERATE_JSON_PAIR_SIZE + 1, arena);
 }
 
+/* NOTE(abid): The seed is the next value of the global random state, so `rand_seed` picks the output.
+ * Pairs come in chunks of GENERATE_CHUNK_PAIRS, a batch of them at a time is generated (across the
+ * pool if there is one) and then written out in order. - 18.Oct.2026 */
 internal stat_f64
-generate_haversine_json(u64 number_pairs, u64 num_clusters, char *filename) {
+__generate_haversine_json_impl(u64 number_pairs, u64 num_clusters, char *filename, generate_opt opt) {
     bench_function_begin();
+    u64 os_start = platform_get_os_timer();
 
     mem_arena *temp_arena = arena_create(kilobyte(1), gigabyte(10));
-    mem_arena *json_arena = arena_create(megabyte(1), terabyte(10));
-    mem_arena *result_arena = arena_create(megabyte(1), terabyte(10));
-
     stat_f64 haversine_stat = {0};
 
-    u64 filename_len = strlen(filename);
-    char *json_extension = ".json";
-    char *f64_extension = ".f64";
-    u64 json_extension_len = strlen(json_extension);
-    u64 f64_extension_len = strlen(f64_extension);
-    char *json_filename = push_size(filename_len + json_extension_len + 1, temp_arena);
-    char *f64_filename = push_size(filename_len + f64_extension_len + 1, temp_arena);
-
-    for(u64 Idx = 0; Idx < filename_len; ++Idx) {
-        json_filename[Idx] = filename[Idx];
-        f64_filename[Idx] = filename[Idx];
+    generate_output output = { .is_json = opt.is_json, .is_dataset = opt.is_dataset };
+    if(opt.is_json) {
+        char prefix[] = "{\"pairs\":[\n";
+        u64 json_size = opt.is_preallocate ? sizeof(prefix) - 1 + number_pairs*GENERATE_JSON_PAIR_SIZE + 3 : 0;
+        bool is_opened = file_writer_open(&output.json, generate_filename(filename, ".json", temp_arena), json_size);
+        assert(is_opened, "cannot create the .json file.");
+        is_opened = file_writer_open(&output.f64, generate_filename(filename, ".f64", temp_arena),
+                                     opt.is_preallocate ? number_pairs*sizeof(f64) : 0);
+        assert(is_opened, "cannot create the .f64 file.");
+        file_writer_write(&output.json, prefix, sizeof(prefix) - 1);
     }
-    for(u64 Idx = 0; Idx < json_extension_len; ++Idx) json_filename[filename_len+Idx] = json_extension[Idx];
-    json_filename[json_extension_len + filename_len] = '\0';
-    for(u64 idx = 0; idx < f64_extension_len; ++idx) f64_filename[filename_len+idx] = f64_extension[idx];
-    f64_filename[f64_extension_len + filename_len] = '\0';
-
-
-    /* NOTE(abid): Alignment to the 8 bytes of f64. */
-    usize alignment = sizeof(f64);
-    assert(result_arena->size >= 2*sizeof(f64)*alignment, "minimum size requirement for result buffer not met.");
-    usize alignment_mask = alignment - 1;
-    if((usize)result_arena->ptr & alignment_mask) {
-        usize aligment_offset = alignment - ((usize)result_arena->ptr & alignment_mask);
-        result_arena->ptr = (void *)((usize)result_arena->ptr + aligment_offset);
-        result_arena->size -= sizeof(f64);
+    if(opt.is_dataset) {
+        bool is_opened = dataset_writer_begin(&output.dataset, generate_filename(filename, DATASET_EXTENSION, temp_arena),
+                                              number_pairs, dataset_has_reference | (opt.is_q32 ? dataset_is_q32 : 0));
+        assert(is_opened, "cannot create the dataset file.");
     }
 
-    char *prefix = "{\"pairs\":[\n";
-    u64 prefix_len = 11;
-    for(; json_arena->used < prefix_len; arena_advance(json_arena, 1, char)) {
-        char *dest = arena_current(json_arena);
-        *dest = prefix[json_arena->used];
+    generate_job job = generate_job_make(number_pairs, num_clusters, opt.is_json, temp_arena);
+    job.is_reference = true;
+
+    /* NOTE(abid): Two chunks per worker a batch, to balance with. */
+    u64 batch_count = opt.pool ? 2*opt.pool->worker_count : 1;
+    job.chunks = push_array_aligned(generate_chunk, batch_count, SIMD_ALIGNMENT, temp_arena);
+    for(u64 idx = 0; idx < batch_count; ++idx) generate_chunk_init(job.chunks + idx, opt.is_json, temp_arena);
+
+    u64 chunk_count = (number_pairs + GENERATE_CHUNK_PAIRS - 1) / GENERATE_CHUNK_PAIRS;
+    for(job.first_chunk = 0; job.first_chunk < chunk_count; job.first_chunk += batch_count) {
+        u64 count = chunk_count - job.first_chunk;
+        if(count > batch_count) count = batch_count;
+
+        if(opt.pool) thread_pool_parallel_for(opt.pool, count, 1, generate_chunk_job_fn, &job);
+        else generate_chunk_job_fn(&job, 0, count, 0);
+        for(u64 idx = 0; idx < count; ++idx) generate_chunk_emit(&output, job.chunks + idx, &haversine_stat);
     }
 
-    if(num_clusters) {
-        // NumClusters = (NumClusters) ? NumClusters : RandRangeU64(20, 300);
-        u64 num_pair_per_cluster = (u64)(number_pairs / num_clusters);
-        u64 pair_remainder = number_pairs % num_clusters;
-        if(pair_remainder) ++num_clusters;
-        for(u64 cluster_idx = 0; cluster_idx < num_clusters; cluster_idx++) {
-            f64 lat1_size = rand_range_f64(10., 100.);
-            f64 lon1_size = rand_range_f64(20., 200.);
-            f64 lat1_start = rand_range_f64(-90., 90. - lat1_size);
-            f64 lon1_start = rand_range_f64(-180., 180. - lon1_size);
-
-            f64 lat2_size = rand_range_f64(10., 100.);
-            f64 lon2_size = rand_range_f64(20., 200.);
-            f64 lat2_start = rand_range_f64(-90., 90. - lat2_size);
-            f64 lon2_start = rand_range_f64(-180., 180. - lon2_size);
-
-            /* NOTE(abid): In case we have remainders left. */
-            u64 num_to_generate = ((cluster_idx == num_clusters-1) && pair_remainder) ? pair_remainder
-                                                                                      : num_pair_per_cluster;
-            for(u64 pair_idx = 0; pair_idx < num_to_generate; pair_idx++) {
-                f64 lat1 = rand_range_f64(lat1_start, lat1_start+lat1_size);
-                f64 lat2 = rand_range_f64(lat2_start, lat2_start+lat2_size);
-                f64 lon1 = rand_range_f64(lon1_start, lon1_start+lon1_size);
-                f64 lon2 = rand_range_f64(lon2_start, lon2_start+lon2_size);
-                stat_f64_accumulate(lat1, &haversine_stat);
-                stat_f64_accumulate(lat2, &haversine_stat);
-                stat_f64_accumulate(lon1, &haversine_stat);
-                stat_f64_accumulate(lon2, &haversine_stat);
-                offload_to_buffer(
-                    json_arena, result_arena, lat1, lat2, lon1, lon2,
-                    cluster_idx*num_pair_per_cluster + pair_idx + 1 == number_pairs,
-                    json_filename, f64_filename
-                );
-            }
-        }
-    } else {
-        for(u64 idx = 0; idx < number_pairs; idx++) {
-            f64 lat1 = rand_range_f64(-90., 90.);
-            f64 lat2 = rand_range_f64(-90., 90.);
-            f64 lon1 = rand_range_f64(-180., 180.);
-            f64 lon2 = rand_range_f64(-180., 180.);
-            stat_f64_accumulate(lat1, &haversine_stat);
-            stat_f64_accumulate(lat2, &haversine_stat);
-            stat_f64_accumulate(lon1, &haversine_stat);
-            stat_f64_accumulate(lon2, &haversine_stat);
-
-            offload_to_buffer(
-                json_arena, result_arena, lat1, lat2, lon1, lon2,
-                idx+1 == number_pairs, json_filename, f64_filename
-            );
+    if(opt.is_json) {
+        file_writer_write(&output.json, "\n]}", 3);
+        bool is_written = file_writer_close(&output.json);
+        is_written = file_writer_close(&output.f64) && is_written;
+        assert(is_written, "cannot write the .json/.f64 files.");
+        if(opt.stats) {
+            opt.stats->json_bytes = output.json.written_bytes;
+            opt.stats->f64_bytes = output.f64.written_bytes;
+            opt.stats->write_time = output.json.write_time + output.f64.write_time;
         }
     }
+    if(opt.is_dataset) {
+        bool is_written = dataset_writer_end(&output.dataset);
+        assert(is_written, "cannot write the dataset file.");
+    }
+    arena_free(temp_arena);
+    if(opt.stats) opt.stats->total_time = platform_get_os_timer() - os_start;
 
     return haversine_stat;
 
     bench_function_end()
 }
+#define generate_haversine_json(number_pairs, num_clusters, filename, ...) \
+    __generate_haversine_json_impl(number_pairs, num_clusters, filename, \
+                                   (generate_opt){ generate_opt_default, __VA_ARGS__ })
@@ -0,0 +1,102 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 17:05:12 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#if !defined(HAVERSINE_H)
+
+/* NOTE(abid): Bytes a `file_writer` buffers, and what its writes are a multiple of (but the last). */
+#define FILE_WRITER_CAPACITY megabyte(4)
+#define FILE_WRITER_ALIGNMENT kilobyte(64)
+
+/* NOTE(abid): A file kept open for the whole run and written in large aligned pieces. Output is
+ * formatted straight into `buffer` (`file_writer_reserve`), when it fills up everything but the
+ * unaligned tail goes out and the tail moves to the front. */
+typedef struct {
+    platform_file file;
+    char *buffer;
+    usize capacity;
+    usize used;
+    u64 written_bytes;
+    u64 write_time; // OS timer ticks spent in writes.
+    bool is_preallocated;
+    bool is_valid; // Cleared by any failed write.
+} file_writer;
+
+/* NOTE(abid): Digits after the point of every coordinate in the .json. */
+#define GENERATE_JSON_PRECISION 20
+/* NOTE(abid): Most a pair can take in the .json with the separator before it, for coordinates within
+ * +-180 degrees (sign and 3 digits before the point). */
+#define GENERATE_JSON_PAIR_SIZE (2 + 2 + 4*(5 + 5 + GENERATE_JSON_PRECISION) + 3*2 + 1)
+
+/* NOTE(abid): Where the time of a `generate_haversine_json` went, in OS timer ticks. Writes are the
+ * .json and .f64 ones, everything else (generating, formatting) is the rest of `total_time`. */
+typedef struct {
+    u64 json_bytes;
+    u64 f64_bytes;
+    u64 write_time;
+    u64 total_time;
+} generate_stats;
+
+/* NOTE(abid): What `generate_haversine_json` writes, the .json/.f64 pair and/or a binary dataset
+ * (DATASET_EXTENSION) with the distances as its reference column, quantized with `is_q32`. With
+ * `is_preallocate` the disk space of the .json/.f64 is reserved before the first write. Chunks are
+ * generated across `pool` when there is one, the output is the same either way. */
+typedef struct {
+    bool is_json;
+    bool is_dataset;
+    bool is_q32;
+    bool is_preallocate;
+    generate_stats *stats;
+    thread_pool *pool;
+} generate_opt;
+#define generate_opt_default .is_json = true, .is_dataset = false, .is_q32 = false, .is_preallocate = false, \
+                             .stats = NULL, .pool = NULL
+
+typedef struct {
+    bool is_json;
+    bool is_dataset;
+    file_writer json;
+    file_writer f64;
+    dataset_writer dataset;
+} generate_output;
+
+/* NOTE(abid): Pairs per chunk of generation. Every chunk draws from its own substream of the seed
+ * (`rand_stream`), and so does every cluster, so a chunk is the same whoever generates it and when. */
+#define GENERATE_CHUNK_PAIRS 16384
+
+/* NOTE(abid): Where the two points of a cluster's pairs come from, in degrees. */
+typedef struct {
+    f64 lat1_start, lat1_size;
+    f64 lon1_start, lon1_size;
+    f64 lat2_start, lat2_size;
+    f64 lon2_start, lon2_size;
+} generate_cluster;
+
+/* NOTE(abid): One chunk of output, generated on any thread and written out in order. */
+typedef struct {
+    u64 first_pair;
+    pair_soa pairs;
+    f64 *distances;
+    char *json; // The chunk's part of the .json, the separator before its first pair included, and a '\0'.
+    usize json_size;
+} generate_chunk;
+
+typedef struct {
+    u64 seed; // Root of every substream.
+    u64 number_pairs;
+    generate_cluster *clusters; // NULL for pairs from anywhere on the globe.
+    u64 cluster_count;
+    u64 pairs_per_cluster; // But the last cluster, which takes what is left (all of it when this is 0).
+    bool is_json;
+    bool is_reference; // Distances are computed into `generate_chunk.distances`.
+
+    u64 first_chunk; // Chunk index of `chunks[0]`.
+    generate_chunk *chunks;
+} generate_job;
+
+#define HAVERSINE_H
+#endif
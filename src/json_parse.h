@@ -38,41 +38,111 @@ typedef struct {
 
 typedef struct {
     char *str;
+    usize length;
     usize current_idx;
 } buffer;
 
-#define TOKEN_TYPES \
-    X(key)          \
-    X(value_float)  \
-    X(value_int)    \
-    X(value_str)    \
-    X(list_begin)   \
-    X(list_end)     \
-    X(dict_begin)   \
-    X(dict_end)     \
-    X(comma)        \
-    X(eot)
+/* NOTE(abid): Bytes indexed per refill of `json_index`, small enough for the positions to stay in
+ * cache between indexing and parsing. */
+#define JSON_INDEX_WINDOW 16384
 
-typedef enum {
-#define X(value) tt_ ## value,
-    TOKEN_TYPES
-#undef X
-} token_type;
-
-char *token_type_str[] = {
-#define X(value) #value,
-    TOKEN_TYPES
-#undef X
-};
-#undef TOKEN_TYPES
+/* NOTE(abid): Structural index of a buffer, built 64 bytes at a time and handed out a window at a
+ * time. Positions are the opening of every dict/list/string, the closing of every dict/list, and
+ * the first byte of every other value (numbers). Whitespace, commas, colons and string contents
+ * never make it in, so the parser only visits bytes it has something to do with. */
+typedef struct {
+    buffer *json_buffer;
+    usize window_start;
+    usize next_block;
+    u32 positions[JSON_INDEX_WINDOW];
+    u32 count;
+    u32 cursor;
 
-typedef struct token token;
-struct token {
-    token_type type;
-    void *body;
+    /* NOTE(abid): Carried from one 64-byte block to the next. */
+    u64 in_string_carry; // All ones if the previous block ended inside a string.
+    u64 scalar_carry; // One if the previous block ended in the middle of a number.
+    simd_level level;
+} json_index;
 
-    token *next;
-};
+/* NOTE(abid): Character classes of one 64-byte block, one bit per byte. */
+typedef struct {
+    u64 quote;
+    u64 bracket; // {}[]
+    u64 separator; // ,:
+    u64 whitespace;
+} json_block_class;
+
+/* NOTE(abid): Input bytes per slice of the "pairs" list in `jp_load_pairs_parallel`. Around 8K
+ * pairs, which makes for plenty of slices to balance with and little to do per slice. */
+#define JP_PAIRS_SLICE_SIZE megabyte(1)
+
+typedef struct {
+    u64 pair_count; // Pairs that start in this slice.
+    u64 first_pair; // Index of the first of them in the arrays.
+    usize end_idx; // Where decoding stopped, past the last pair and its comma.
+    bool is_valid;
+    bool is_list_end; // The last pair had no comma after it.
+} jp_pairs_slice;
+
+typedef struct {
+    buffer *json_buffer;
+    pair_soa *pairs;
+    usize list_start;
+    usize slice_size;
+    jp_pairs_slice *slices;
+} jp_pairs_job;
+
+/* NOTE(abid): Pairs handed out per call of the sink in `jp_stream_pairs`. */
+#define JP_STREAM_BATCH_COUNT 4096
+
+/* NOTE(abid): Gets every batch of pairs read by `jp_stream_pairs`, the batch is reused once it
+ * returns. */
+typedef void jp_pairs_sink(pair_soa *pairs, void *data);
+
+/* NOTE(abid): Where the time of a `jp_stream_pairs` went, in OS timer ticks. Reading is timed on
+ * whichever thread does it, waiting is the time the parser sat idle for data, everything else is
+ * the parser's. */
+typedef struct {
+    u64 read_bytes;
+    u64 read_time;
+    u64 wait_time;
+    u64 total_time;
+} jp_stream_stats;
+
+/* NOTE(abid): Reads ahead of the parser on its own thread, into two staging buffers used in turn.
+ * `slot_free` counts the buffers the reader may fill, `slot_full` the ones the parser may take, so
+ * the next read is going on while the current chunk is parsed. */
+typedef struct {
+    FILE *handle;
+    platform_thread thread;
+    platform_semaphore slot_free;
+    platform_semaphore slot_full;
+    char *slots[2];
+    usize slot_counts[2];
+    bool slot_is_eof[2]; // The read into this slot hit the end of the file, nothing comes after it.
+    volatile bool is_quit;
+    usize slot_size;
+    u64 read_time; // Only written by the reader.
+
+    /* NOTE(abid): Parser side. */
+    u32 slot_idx;
+    usize slot_offset;
+    bool is_slot_taken; // `slot_idx` is filled and being copied out of.
+} jp_stream_reader;
+
+/* NOTE(abid): A file read a chunk at a time into `chunk`, what is left unparsed at the end of a
+ * chunk is carried over to the front of the next one. */
+typedef struct {
+    FILE *handle;
+    buffer chunk;
+    usize capacity;
+    bool is_eof;
+    jp_stream_reader *reader; // NULL to read on the parser's thread.
+    jp_stream_stats stats;
+} jp_stream;
+
+typedef struct { bool is_async; jp_stream_stats *stats; } jp_stream_opt;
+#define jp_stream_opt_default .is_async = false, .stats = NULL
 
 typedef enum {
     jvt_dict,
@@ -81,27 +151,86 @@ typedef enum {
     jvt_str,
     jvt_float,
     jvt_int,
+    /* NOTE(abid): Lazy number, not converted yet. The payload points at its text in the source
+     * buffer, it becomes a `jvt_float`/`jvt_int` in place the first time it is read. */
+    jvt_number,
 } json_value_type;
 
 /* NOTE(abid): This is just a stub used to define the type of the value. Once the type is known
- * one can `+= sizeof(json_value)` to get the actual json value. - 28.Sep.2024 */
+ * one can `+= sizeof(json_value)` to get the actual json value. - 28.Sep.2024
+ * Values are now slots of JSON_SLOT_SIZE stored inline in the dict/list they are in, the stub
+ * followed by 8 bytes. Scalars are in those 8 bytes, a dict/list is a u32 offset from its slot to
+ * its body (`json_dict`/`json_list` and then its slots), in units of JSON_OFFSET_UNIT. Use
+ * `jp_value_body` to get either. - 18.Oct.2026
+ * A slot is 12 bytes, so the payload of every other one is not 8-byte aligned: scalars only ever
+ * go through the `jp_payload_*` routines (memcpy, a plain load on x86), never a cast. */
 typedef struct {
     json_value_type type;
 } json_value;
 
+#define JSON_SLOT_SIZE (sizeof(json_value) + sizeof(u64))
+/* NOTE(abid): Every body and string in the JSON arena starts at a multiple of this, so the pointers
+ * and sizes of `json_dict`/`json_list` are aligned. */
+#define JSON_ALIGNMENT 8
+/* NOTE(abid): Slots are at multiples of this, so body offsets are in units of it and reach 16GB
+ * with 32 bits. */
+#define JSON_OFFSET_UNIT 4
+
+/* NOTE(abid): Most a shape's key table is filled before it doubles, in percent. Half full keeps
+ * almost every lookup to one probe, it costs a 24-byte entry per empty spot but there is only one
+ * table per shape. Define it before including to trade memory for probes. */
+#if !defined(JP_TABLE_MAX_LOAD_PERCENT)
+#define JP_TABLE_MAX_LOAD_PERCENT 50
+#endif
+
+/* NOTE(abid): Buckets of `jp_shape_probe_histogram`, the last one also counts anything longer. */
+#define JP_PROBE_HISTOGRAM_COUNT 8
+
+/* NOTE(abid): Entry of a shape's key table, `slot` is where the value of `key` is in a dict. A
+ * NULL `key` is an empty entry. */
 typedef struct {
     char *key;
-    json_value *value;
-} dict_kv;
+    usize hash; // Of `key`, compared before the key itself on lookup.
+    u32 length;
+    u32 slot;
+} shape_kv;
+
+/* NOTE(abid): Key set of a dict, in the order the keys came in ("hidden class"). Every dict with
+ * the same keys in the same order shares one shape, so the keys are stored once per shape instead
+ * of once per dict, and a dict is only its values. A shape is its parent plus one key, the children
+ * are the shapes reached by adding one more key, found again the next time the same key is added. */
+typedef struct json_shape json_shape;
+struct json_shape {
+    char *key; // The key this shape added, the rest are up the parents.
+    usize hash;
+    usize count; // Keys in the shape, `key` is at slot count-1.
+    json_shape *parent;
+    json_shape *first_child;
+    json_shape *next_sibling;
+    shape_kv *table; // Built the first time a dict ends with this shape.
+    usize table_mask; // Entries in `table` minus one, a power of two.
+};
+
+/* NOTE(abid): Key hashed once with `jp_key_make`, for looking up the same key in many dicts. It
+ * also remembers the last shape it was found in and at which slot, dicts of that shape are a
+ * compare and an index away. */
+typedef struct {
+    char *str;
+    usize length;
+    usize hash;
+    json_shape *shape;
+    usize slot;
+} jp_key;
 
+/* NOTE(abid): Followed by `count` slots, the values in shape order. */
 typedef struct {
-    usize count; // count of `table` structure, used for hash function modulus
-    dict_kv *table;
+    json_shape *shape;
+    usize count; // Values the dict has room for, from the pre-count.
 } json_dict;
 
+/* NOTE(abid): Followed by `count` slots. */
 typedef struct {
     usize count;
-    json_value **array;
 } json_list;
 
 typedef struct json_scope json_scope;
@@ -109,11 +238,17 @@ typedef struct {
     json_value *json;
 
     mem_arena *temp_arena;
-    token *token_list;
-    token *current_token;
+    mem_arena *count_arena;
     usize global_bytes_size;
+    /* NOTE(abid): Element count of every dict/list in the order they open, from `jp_precount`. */
+    usize *container_counts;
+    usize container_count;
 
     json_scope *scope_free_list;
+    /* NOTE(abid): Shapes live as long as the JSON, next to it. */
+    mem_arena *shape_arena;
+    json_shape *shape_root; // No keys, every dict starts here.
+    bool is_lazy; // Numbers are left as `jvt_number` for the getters to convert.
 } parser_state;
 
 
@@ -123,8 +258,9 @@ struct json_scope {
     json_value *content;
     union {
         usize idx; // Index to be used in the context, set by routine to track dict and list free boundary.
-        usize count; // Used with lexer, to keep count of a scope (dict/list)
+        usize count; // Used with pre-count, to keep count of a scope (dict/list)
     };
+    usize container_idx; // Used with pre-count, where in `container_counts` the count goes.
     json_scope *parent;
 };
 
@@ -0,0 +1,469 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 10:39:21 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#include "kernel.h"
+#include "simd.h"
+
+/* NOTE(abid): Instantiate the templated routines once per ISA. */
+#define SIMD_ISA SIMD_ISA_SCALAR
+#include "simd.h"
+#include "simd_math.c"
+#include "simd_kernel.c"
+#include "simd_random.c"
+#undef SIMD_ISA
+
+#define SIMD_ISA SIMD_ISA_SSE2
+#include "simd.h"
+#include "simd_math.c"
+#include "simd_kernel.c"
+#include "simd_random.c"
+#undef SIMD_ISA
+
+#define SIMD_ISA SIMD_ISA_AVX2
+#include "simd.h"
+#include "simd_math.c"
+#include "simd_kernel.c"
+#include "simd_random.c"
+#undef SIMD_ISA
+
+#define SIMD_ISA SIMD_ISA_AVX512
+#include "simd.h"
+#include "simd_math.c"
+#include "simd_kernel.c"
+#include "simd_random.c"
+#undef SIMD_ISA
+
+/* NOTE(abid): Set on first use of a batch routine, or forced with `kernel_simd_level_set`. */
+global_var simd_level __GLOBAL_simd_level = simd_level_count;
+/* NOTE(abid): Tier used when a call does not ask for one, see `kernel_math_tier_set`. */
+global_var math_tier __GLOBAL_math_tier = math_tier_precise;
+
+internal simd_level
+kernel_simd_level_detect() {
+    simd_level result = simd_level_scalar;
+
+    u32 regs[4] = {0};
+    platform_cpuid(0, 0, regs);
+    u32 max_leaf = regs[0];
+
+    platform_cpuid(1, 0, regs);
+    bool has_sse2 = (regs[3] >> 26) & 1;
+    bool has_osxsave = (regs[2] >> 27) & 1;
+    bool has_avx = (regs[2] >> 28) & 1;
+    bool has_fma = (regs[2] >> 12) & 1;
+    if(has_sse2) result = simd_level_sse2;
+
+    /* NOTE(abid): The OS must also save the wide registers on context switch, that is XCR0. */
+    if(has_osxsave && has_avx && max_leaf >= 7) {
+        u64 xcr0 = platform_xgetbv(0);
+        platform_cpuid(7, 0, regs);
+        bool has_avx2 = (regs[1] >> 5) & 1;
+        bool has_avx512f = (regs[1] >> 16) & 1;
+
+        if(has_avx2 && has_fma && (xcr0 & 0x6) == 0x6) result = simd_level_avx2;
+        if(has_avx512f && (xcr0 & 0xE6) == 0xE6) result = simd_level_avx512;
+    }
+
+    return result;
+}
+
+inline internal void
+kernel_simd_level_set(simd_level level) {
+    /* NOTE(abid): Never go above what the machine can do. */
+    simd_level supported = kernel_simd_level_detect();
+    __GLOBAL_simd_level = (level > supported) ? supported : level;
+}
+
+inline internal simd_level
+kernel_simd_level_get() {
+    if(__GLOBAL_simd_level == simd_level_count) __GLOBAL_simd_level = kernel_simd_level_detect();
+    return __GLOBAL_simd_level;
+}
+
+/* NOTE(abid): Allocates the four arrays of `count` pairs, aligned for the kernels. */
+internal pair_soa
+pair_soa_create(u64 count, mem_arena *arena) {
+    return (pair_soa) {
+        .count = count,
+        .x0 = push_array_aligned(f64, count, SIMD_ALIGNMENT, arena),
+        .y0 = push_array_aligned(f64, count, SIMD_ALIGNMENT, arena),
+        .x1 = push_array_aligned(f64, count, SIMD_ALIGNMENT, arena),
+        .y1 = push_array_aligned(f64, count, SIMD_ALIGNMENT, arena),
+    };
+}
+
+inline internal pair_soa
+pair_soa_slice(pair_soa *pairs, u64 first, u64 count) {
+    assert(first + count <= pairs->count, "slice out of bounds");
+    return (pair_soa) {
+        .count = count,
+        .x0 = pairs->x0 + first,
+        .y0 = pairs->y0 + first,
+        .x1 = pairs->x1 + first,
+        .y1 = pairs->y1 + first,
+    };
+}
+
+inline internal void
+kernel_math_tier_set(math_tier tier) {
+    assert(tier < math_tier_count, "invalid math tier");
+    __GLOBAL_math_tier = tier;
+}
+
+inline internal math_tier
+kernel_math_tier_get() { return __GLOBAL_math_tier; }
+
+/* NOTE(abid): Scalar versions of the tiered functions, for callers outside the batch kernels. */
+inline internal f64
+math_sin(f64 x, math_tier tier) { return (tier == math_tier_libm) ? sin(x) : simd_sin_scalar(x, tier); }
+inline internal f64
+math_cos(f64 x, math_tier tier) { return (tier == math_tier_libm) ? cos(x) : simd_cos_scalar(x, tier); }
+inline internal f64
+math_asin(f64 x, math_tier tier) { return (tier == math_tier_libm) ? asin(x) : simd_asin_scalar(x, tier); }
+inline internal f64
+math_sqrt(f64 x, math_tier tier) { (void)tier; return sqrt(x); }
+
+/* NOTE(abid): Computes the distance of every pair into `distances` (`pairs->count` of them).
+ * Optionally takes `.tier = math_tier_*`, otherwise (math_tier_count) uses the per-run tier.
+ * The sums also take `.reduction = reduction_*`, which the per-pair routines ignore, and the chord
+ * routines take `.is_chord_only`. */
+typedef struct { math_tier tier; reduction_mode reduction; bool is_chord_only; } haversine_batch_opt;
+#define haversine_batch_opt_default .tier = math_tier_count, .reduction = reduction_fast, .is_chord_only = false
+#define haversine_batch(pairs, distances, earth_radius, ...) \
+    __haversine_batch_impl(pairs, distances, earth_radius, \
+                           (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal void
+__haversine_batch_impl(pair_soa *pairs, f64 *distances, f64 earth_radius, haversine_batch_opt opt) {
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    if(opt.tier == math_tier_libm) {
+        for(u64 idx = 0; idx < pairs->count; ++idx) {
+            distances[idx] = haversine(pairs->x0[idx], pairs->y0[idx],
+                                       pairs->x1[idx], pairs->y1[idx], earth_radius);
+        }
+        return;
+    }
+
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: { haversine_batch_avx512(pairs, distances, earth_radius, opt.tier); } break;
+        case simd_level_avx2: { haversine_batch_avx2(pairs, distances, earth_radius, opt.tier); } break;
+        case simd_level_sse2: { haversine_batch_sse2(pairs, distances, earth_radius, opt.tier); } break;
+        case simd_level_scalar: { haversine_batch_scalar(pairs, distances, earth_radius, opt.tier); } break;
+        default: assert(0, "invalid simd level");
+    }
+}
+
+/* NOTE(abid): Exact-sums the distances into `sum`, going through the per-pair kernel a block at a
+ * time so the distances never have to be stored. */
+internal void
+haversine_batch_accumulate(pair_soa *pairs, f64 earth_radius, exact_sum *sum, haversine_batch_opt opt) {
+    f64 distances[1024];
+    for(u64 first = 0; first < pairs->count; first += array_size(distances)) {
+        u64 count = pairs->count - first;
+        if(count > array_size(distances)) count = array_size(distances);
+
+        pair_soa block = pair_soa_slice(pairs, first, count);
+        __haversine_batch_impl(&block, distances, earth_radius, opt);
+        exact_sum_add_array(sum, distances, count);
+    }
+}
+
+#define haversine_batch_sum(pairs, earth_radius, ...) \
+    __haversine_batch_sum_impl(pairs, earth_radius, \
+                               (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal f64
+__haversine_batch_sum_impl(pair_soa *pairs, f64 earth_radius, haversine_batch_opt opt) {
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    if(opt.reduction == reduction_exact) {
+        exact_sum sum = {0};
+        haversine_batch_accumulate(pairs, earth_radius, &sum, opt);
+        return exact_sum_result(&sum);
+    }
+
+    f64 result = 0;
+    if(opt.tier == math_tier_libm) {
+        for(u64 idx = 0; idx < pairs->count; ++idx) {
+            result += haversine(pairs->x0[idx], pairs->y0[idx],
+                                pairs->x1[idx], pairs->y1[idx], earth_radius);
+        }
+        return result;
+    }
+
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: { result = haversine_batch_sum_avx512(pairs, earth_radius, opt.tier); } break;
+        case simd_level_avx2: { result = haversine_batch_sum_avx2(pairs, earth_radius, opt.tier); } break;
+        case simd_level_sse2: { result = haversine_batch_sum_sse2(pairs, earth_radius, opt.tier); } break;
+        case simd_level_scalar: { result = haversine_batch_sum_scalar(pairs, earth_radius, opt.tier); } break;
+        default: assert(0, "invalid simd level");
+    }
+
+    return result;
+}
+
+internal pair_soa_q32
+pair_soa_q32_create(u64 count, mem_arena *arena) {
+    return (pair_soa_q32) {
+        .count = count,
+        .x0 = push_array_aligned(i32, count, SIMD_ALIGNMENT, arena),
+        .y0 = push_array_aligned(i32, count, SIMD_ALIGNMENT, arena),
+        .x1 = push_array_aligned(i32, count, SIMD_ALIGNMENT, arena),
+        .y1 = push_array_aligned(i32, count, SIMD_ALIGNMENT, arena),
+    };
+}
+
+internal pair_soa_q32
+pair_soa_quantize(pair_soa *pairs, mem_arena *arena) {
+    pair_soa_q32 result = pair_soa_q32_create(pairs->count, arena);
+    for(u64 idx = 0; idx < pairs->count; ++idx) {
+        result.x0[idx] = q32_from_degrees(pairs->x0[idx]);
+        result.y0[idx] = q32_from_degrees(pairs->y0[idx]);
+        result.x1[idx] = q32_from_degrees(pairs->x1[idx]);
+        result.y1[idx] = q32_from_degrees(pairs->y1[idx]);
+    }
+
+    return result;
+}
+
+/* NOTE(abid): `haversine_batch`/`haversine_batch_sum` of quantized pairs, taking `.tier` only. */
+#define haversine_batch_q32(pairs, distances, earth_radius, ...) \
+    __haversine_batch_q32_impl(pairs, distances, earth_radius, \
+                               (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal void
+__haversine_batch_q32_impl(pair_soa_q32 *pairs, f64 *distances, f64 earth_radius, haversine_batch_opt opt) {
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    if(opt.tier == math_tier_libm) {
+        for(u64 idx = 0; idx < pairs->count; ++idx) {
+            distances[idx] = haversine(degrees_from_q32(pairs->x0[idx]), degrees_from_q32(pairs->y0[idx]),
+                                       degrees_from_q32(pairs->x1[idx]), degrees_from_q32(pairs->y1[idx]),
+                                       earth_radius);
+        }
+        return;
+    }
+
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: { haversine_batch_q32_avx512(pairs, distances, earth_radius, opt.tier); } break;
+        case simd_level_avx2: { haversine_batch_q32_avx2(pairs, distances, earth_radius, opt.tier); } break;
+        case simd_level_sse2: { haversine_batch_q32_sse2(pairs, distances, earth_radius, opt.tier); } break;
+        case simd_level_scalar: { haversine_batch_q32_scalar(pairs, distances, earth_radius, opt.tier); } break;
+        default: assert(0, "invalid simd level");
+    }
+}
+
+#define haversine_batch_sum_q32(pairs, earth_radius, ...) \
+    __haversine_batch_sum_q32_impl(pairs, earth_radius, \
+                                   (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal f64
+__haversine_batch_sum_q32_impl(pair_soa_q32 *pairs, f64 earth_radius, haversine_batch_opt opt) {
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+
+    f64 result = 0;
+    if(opt.tier == math_tier_libm) {
+        for(u64 idx = 0; idx < pairs->count; ++idx) {
+            result += haversine(degrees_from_q32(pairs->x0[idx]), degrees_from_q32(pairs->y0[idx]),
+                                degrees_from_q32(pairs->x1[idx]), degrees_from_q32(pairs->y1[idx]),
+                                earth_radius);
+        }
+        return result;
+    }
+
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: { result = haversine_batch_sum_q32_avx512(pairs, earth_radius, opt.tier); } break;
+        case simd_level_avx2: { result = haversine_batch_sum_q32_avx2(pairs, earth_radius, opt.tier); } break;
+        case simd_level_sse2: { result = haversine_batch_sum_q32_sse2(pairs, earth_radius, opt.tier); } break;
+        case simd_level_scalar: { result = haversine_batch_sum_q32_scalar(pairs, earth_radius, opt.tier); } break;
+        default: assert(0, "invalid simd level");
+    }
+
+    return result;
+}
+
+internal void
+rand_lanes_fill_unit(rand_lanes *lanes, f64 *dest, u64 count) {
+    u64 round_count = count / RAND_LANE_COUNT;
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: { rand_lanes_fill_unit_avx512(lanes, dest, round_count); } break;
+        case simd_level_avx2: { rand_lanes_fill_unit_avx2(lanes, dest, round_count); } break;
+        case simd_level_sse2: { rand_lanes_fill_unit_sse2(lanes, dest, round_count); } break;
+        case simd_level_scalar: { rand_lanes_fill_unit_scalar(lanes, dest, round_count); } break;
+        default: assert(0, "invalid simd level");
+    }
+
+    u64 tail_count = count - round_count*RAND_LANE_COUNT;
+    if(tail_count) {
+        f64 tail[RAND_LANE_COUNT];
+        rand_lanes_fill_unit_scalar(lanes, tail, 1);
+        memcpy(dest + round_count*RAND_LANE_COUNT, tail, tail_count*sizeof(f64));
+    }
+}
+
+/* NOTE(abid): Range [min, max). The scaling is left out of the templated part, the compiler
+ * vectorizes it anyway and an FMA there would make the result depend on the ISA. */
+internal void
+rand_lanes_fill_range_f64(rand_lanes *lanes, f64 *dest, u64 count, f64 min, f64 max) {
+    rand_lanes_fill_unit(lanes, dest, count);
+    f64 size = max - min;
+    for(u64 idx = 0; idx < count; ++idx) dest[idx] = min + dest[idx]*size;
+}
+
+/* NOTE(abid): 16K pairs is 512KB of input per chunk, big enough to not feel the deque and small
+ * enough to balance well on 64 cores with 100M pairs. */
+#define HAVERSINE_CHUNK_SIZE 16384
+
+typedef struct {
+    pair_soa *pairs;
+    f64 earth_radius;
+    haversine_batch_opt opt;
+    f64 *chunk_sums; /* NOTE(abid): For reduction_fast, one per chunk. */
+    exact_sum *worker_sums; /* NOTE(abid): For reduction_exact, one per worker. */
+} haversine_sum_job;
+
+internal void
+haversine_sum_job_fn(void *data, u64 first, u64 count, u32 worker_idx) {
+    haversine_sum_job *job = (haversine_sum_job *)data;
+    pair_soa chunk = pair_soa_slice(job->pairs, first, count);
+    if(job->opt.reduction == reduction_exact) {
+        haversine_batch_accumulate(&chunk, job->earth_radius, job->worker_sums + worker_idx, job->opt);
+    } else {
+        job->chunk_sums[first / HAVERSINE_CHUNK_SIZE] = __haversine_batch_sum_impl(&chunk, job->earth_radius, job->opt);
+    }
+}
+
+/* NOTE(abid): Sum of all distances across the pool. With reduction_fast, chunk sums are added up in
+ * chunk order at the end, so the result does not depend on the thread count, but does on the chunk
+ * size. With reduction_exact every worker keeps an exact accumulator and those are merged, so the
+ * result depends on nothing but the distances (which can still differ between ISAs). */
+#define haversine_parallel_sum(pool, pairs, earth_radius, ...) \
+    __haversine_parallel_sum_impl(pool, pairs, earth_radius, \
+                                  (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal f64
+__haversine_parallel_sum_impl(thread_pool *pool, pair_soa *pairs, f64 earth_radius, haversine_batch_opt opt) {
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    /* NOTE(abid): Resolve the ISA before the workers race to do it. */
+    kernel_simd_level_get();
+
+    temp_memory temp = mem_temp_begin(pool->arena);
+    u64 chunk_count = (pairs->count + HAVERSINE_CHUNK_SIZE - 1) / HAVERSINE_CHUNK_SIZE;
+    haversine_sum_job job = {
+        .pairs = pairs,
+        .earth_radius = earth_radius,
+        .opt = opt,
+    };
+    if(opt.reduction == reduction_exact) {
+        job.worker_sums = push_array(exact_sum, pool->worker_count, pool->arena);
+        for(u32 idx = 0; idx < pool->worker_count; ++idx) job.worker_sums[idx] = (exact_sum){0};
+    } else job.chunk_sums = push_array(f64, chunk_count, pool->arena);
+
+    thread_pool_parallel_for(pool, pairs->count, HAVERSINE_CHUNK_SIZE, haversine_sum_job_fn, &job);
+
+    f64 result = 0;
+    if(opt.reduction == reduction_exact) {
+        for(u32 idx = 1; idx < pool->worker_count; ++idx) exact_sum_merge(job.worker_sums, job.worker_sums + idx);
+        result = exact_sum_result(job.worker_sums);
+    } else {
+        for(u64 idx = 0; idx < chunk_count; ++idx) result += job.chunk_sums[idx];
+    }
+    mem_temp_end(temp);
+
+    return result;
+}
+
+/* NOTE(abid): Unit vectors of the points at `lon[i]`, `lat[i]` (degrees), so x/y of pair_soa map
+ * to lon/lat. This is where all the trig goes, do it once at load time. */
+#define unit_vec_soa_from_degrees(lon, lat, count, arena, ...) \
+    __unit_vec_soa_from_degrees_impl(lon, lat, count, arena, \
+                                     (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal unit_vec_soa
+__unit_vec_soa_from_degrees_impl(f64 *lon, f64 *lat, u64 count, mem_arena *arena, haversine_batch_opt opt) {
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    unit_vec_soa result = {
+        .count = count,
+        .x = push_array_aligned(f64, count, SIMD_ALIGNMENT, arena),
+        .y = push_array_aligned(f64, count, SIMD_ALIGNMENT, arena),
+        .z = push_array_aligned(f64, count, SIMD_ALIGNMENT, arena),
+    };
+
+    if(opt.tier == math_tier_libm) {
+        for(u64 idx = 0; idx < count; ++idx) {
+            f64 lon_rad = radians_from_degrees(1.0) * lon[idx];
+            f64 lat_rad = radians_from_degrees(1.0) * lat[idx];
+            result.x[idx] = cos(lat_rad) * cos(lon_rad);
+            result.y[idx] = cos(lat_rad) * sin(lon_rad);
+            result.z[idx] = sin(lat_rad);
+        }
+        return result;
+    }
+
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: { unit_vec_from_degrees_avx512(lon, lat, &result, opt.tier); } break;
+        case simd_level_avx2: { unit_vec_from_degrees_avx2(lon, lat, &result, opt.tier); } break;
+        case simd_level_sse2: { unit_vec_from_degrees_sse2(lon, lat, &result, opt.tier); } break;
+        case simd_level_scalar: { unit_vec_from_degrees_scalar(lon, lat, &result, opt.tier); } break;
+        default: assert(0, "invalid simd level");
+    }
+
+    return result;
+}
+
+/* NOTE(abid): The chord length (in units of `earth_radius`) that matches a great-circle distance,
+ * to turn a distance threshold into one for `.is_chord_only` results. */
+inline internal f64
+chord_from_distance(f64 distance, f64 earth_radius) {
+    return 2.0 * earth_radius * sin(distance / (2.0 * earth_radius));
+}
+
+/* NOTE(abid): Distance between `a[i]` and `b[i]` into `distances`. With `.is_chord_only` it is the
+ * straight-line chord instead, which is monotonic in the distance and so enough for ranking and
+ * thresholds (see `chord_from_distance`), and it skips the asin. */
+#define chord_batch(a, b, distances, earth_radius, ...) \
+    __chord_batch_impl(a, b, distances, earth_radius, \
+                       (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal void
+__chord_batch_impl(unit_vec_soa *a, unit_vec_soa *b, f64 *distances, f64 earth_radius, haversine_batch_opt opt) {
+    assert(a->count == b->count, "point count mismatch");
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    /* NOTE(abid): There is no trig left but asin, libm gets no better than the precise tier here. */
+    if(opt.tier == math_tier_libm) opt.tier = math_tier_precise;
+
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: { chord_batch_avx512(a, b, distances, earth_radius, opt.is_chord_only, opt.tier); } break;
+        case simd_level_avx2: { chord_batch_avx2(a, b, distances, earth_radius, opt.is_chord_only, opt.tier); } break;
+        case simd_level_sse2: { chord_batch_sse2(a, b, distances, earth_radius, opt.is_chord_only, opt.tier); } break;
+        case simd_level_scalar: { chord_batch_scalar(a, b, distances, earth_radius, opt.is_chord_only, opt.tier); } break;
+        default: assert(0, "invalid simd level");
+    }
+}
+
+/* NOTE(abid): Distance from every point to `points[query_idx]`, same options as `chord_batch`. */
+#define chord_to_point_batch(points, query_idx, distances, earth_radius, ...) \
+    __chord_to_point_batch_impl(points, query_idx, distances, earth_radius, \
+                                (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal void
+__chord_to_point_batch_impl(unit_vec_soa *points, u64 query_idx, f64 *distances, f64 earth_radius,
+                            haversine_batch_opt opt) {
+    assert(query_idx < points->count, "query point out of bounds");
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    if(opt.tier == math_tier_libm) opt.tier = math_tier_precise;
+
+    f64 qx = points->x[query_idx];
+    f64 qy = points->y[query_idx];
+    f64 qz = points->z[query_idx];
+    switch(kernel_simd_level_get()) {
+        case simd_level_avx512: {
+            chord_to_point_batch_avx512(points, qx, qy, qz, distances, earth_radius, opt.is_chord_only, opt.tier);
+        } break;
+        case simd_level_avx2: {
+            chord_to_point_batch_avx2(points, qx, qy, qz, distances, earth_radius, opt.is_chord_only, opt.tier);
+        } break;
+        case simd_level_sse2: {
+            chord_to_point_batch_sse2(points, qx, qy, qz, distances, earth_radius, opt.is_chord_only, opt.tier);
+        } break;
+        case simd_level_scalar: {
+            chord_to_point_batch_scalar(points, qx, qy, qz, distances, earth_radius, opt.is_chord_only, opt.tier);
+        } break;
+        default: assert(0, "invalid simd level");
+    }
+}
@@ -0,0 +1,88 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 10:39:55 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#if !defined(KERNEL_H)
+
+/* NOTE(abid): Pairs laid out as four contiguous arrays, the way the batch kernels want them.
+ * Arrays should be SIMD_ALIGNMENT aligned, though the kernels do not require it. */
+typedef struct {
+    u64 count;
+    f64 *x0;
+    f64 *y0;
+    f64 *x1;
+    f64 *y1;
+} pair_soa;
+
+/* NOTE(abid): Pairs with every coordinate in degrees times PAIR_Q32_SCALE, rounded to an i32. Half
+ * the bytes of `pair_soa`, for when moving the data costs more than the math. A step of 1e-7 degrees
+ * is ~1.1 cm on the ground and +-180 degrees still fits. Against the .f64 reference of the 1M pair,
+ * 64 cluster file (see `test_q32_error`) the distances are off by at most 1.4e-05 km (3.8e-07
+ * relative), 3.3e-06 km on average, at every ISA and the precise and libm tiers alike. That is the
+ * rounding of the coordinates, the decode itself is exact to an ulp. Once in memory the sum is
+ * compute bound and takes as long as with f64, the saving is in what has to be read in. - 18.Oct.2026 */
+#define PAIR_Q32_SCALE 1e7
+typedef struct {
+    u64 count;
+    i32 *x0;
+    i32 *y0;
+    i32 *x1;
+    i32 *y1;
+} pair_soa_q32;
+
+/* NOTE(abid): Here rather than kernel.c for the dataset writer, which comes before it. */
+inline internal i32
+q32_from_degrees(f64 degrees) { return (i32)lround(degrees * PAIR_Q32_SCALE); }
+inline internal f64
+degrees_from_q32(i32 value) { return (f64)value * (1.0 / PAIR_Q32_SCALE); }
+
+/* NOTE(abid): Points as unit vectors on the sphere (x towards lon 0, z towards the north pole), one
+ * array per axis. Precomputed once so repeated distance queries are trig-free, see
+ * `unit_vec_soa_from_degrees`. On the 1M pair file (avx512, see `test_unit_vec`) the precompute is
+ * ~30 ns/pair with the first touch of the arrays, after which `chord_batch` is ~4 ns/pair against
+ * ~15 for `haversine_batch`, at the same error. */
+typedef struct {
+    u64 count;
+    f64 *x;
+    f64 *y;
+    f64 *z;
+} unit_vec_soa;
+
+typedef enum {
+    simd_level_scalar,
+    simd_level_sse2,
+    simd_level_avx2,
+    simd_level_avx512,
+
+    simd_level_count
+} simd_level;
+
+char *simd_level_str[] = { "scalar", "sse2", "avx2", "avx512" };
+
+/* NOTE(abid): Accuracy tier of the sin/cos/asin used by the kernels (sqrt is always the hardware
+ * one, it is correctly rounded and already vectorizes). Measured against the .f64 reference of a
+ * 1M pair, 64 cluster file (seed 1234), avx2, see `test_math_tiers` (errors are the same on avx512):
+ *
+ *   tier       max abs error    max rel error    ns/pair
+ *   libm       0                0                ~105
+ *   precise    2.4e-09 km       1.2e-13          ~19
+ *   fast       1.2e-05 km       6.0e-10          ~13
+ *
+ * The relative error of the distance is larger than that of the functions themselves near
+ * antipodal pairs, where asin(sqrt(a)) is ill-conditioned. - 18.Oct.2026 */
+typedef enum {
+    math_tier_libm,
+    math_tier_precise,
+    math_tier_fast,
+
+    math_tier_count
+} math_tier;
+
+char *math_tier_str[] = { "libm", "precise", "fast" };
+
+#define KERNEL_H
+#endif
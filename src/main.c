@@ -16,17 +16,47 @@
 #include "types.h"
 #include "utils.c"
 #include "bench.h"
+#include "thread_pool.c"
 #include "random.c"
 #include "stat.c"
+#include "reduce.c"
+#include "dataset.c"
 #include "haversine.c"
+#include "kernel.c"
+#include "verify.c"
+#include "number_parse.c"
 #include "json_parse.c"
+#include "pipeline.c"
+
+/* NOTE(abid): The "pairs" file as SoA, through the schema-specialized loader when the file has
+ * the expected shape, through the DOM otherwise. */
+internal pair_soa
+pair_soa_load_json(char *filename, mem_arena *arena) {
+    pair_soa result;
+    if(!jp_load_pairs(filename, &result, arena)) {
+        json_dict *json = jp_load(filename);
+        json_list *pairs = jp_get_dict_value(json, "pairs", json_list);
+        result = pair_soa_create(pairs->count, arena);
+        jp_key x0 = jp_key_make("x0"), y0 = jp_key_make("y0"), x1 = jp_key_make("x1"), y1 = jp_key_make("y1");
+        for(u64 idx = 0; idx < pairs->count; ++idx) {
+            json_dict *elem = jp_get_list_elem(pairs, idx, json_dict);
+            result.x0[idx] = jp_value_as_f64(_jp_get_dict_value_key(elem, &x0));
+            result.x1[idx] = jp_value_as_f64(_jp_get_dict_value_key(elem, &x1));
+            result.y0[idx] = jp_value_as_f64(_jp_get_dict_value_key(elem, &y0));
+            result.y1[idx] = jp_value_as_f64(_jp_get_dict_value_key(elem, &y1));
+        }
+    }
+
+    return result;
+}
 
 typedef struct {
     f64 *f64_buffer;
-    json_dict *json;
+    pair_soa pairs;
+    platform_file_mapping mapping; // What `f64_buffer` points into, see `haversine_files_close`.
 } haversine_files;
 internal haversine_files
-load_json_f64_files(char *filename) {
+load_json_f64_files(char *filename, mem_arena *arena) {
     bench_function_begin();
     /* NOTE(abid): `filename` should be without extension. */
 
@@ -43,51 +73,737 @@ load_json_f64_files(char *filename) {
     for(idx = 0; idx < json_extension_len; ++idx)
         temp[idx + filename_len] = json_extension[idx];
     temp[idx + filename_len] = '\0';
-    json_dict *json = jp_load(temp);
+    pair_soa pairs = pair_soa_load_json(temp, arena);
 
     /* NOTE(abid): Load .f64 file. */
     for(idx = 0; idx < f64_extension_len; ++idx)
         temp[idx + filename_len] = f64_extension[idx];
     temp[idx + filename_len] = '\0';
-    f64 *f64_buffer = read_file(temp, sizeof(f64));
+    platform_file_mapping f64_mapping;
+    bool is_mapped = platform_file_map(temp, file_map_sequential, &f64_mapping);
+    assert(is_mapped, "file could not be opened.");
+    /* NOTE(abid): Everything reading the distances goes by the pair count, a .f64 cut short or of
+     * another .json would be read past its end. */
+    assert(f64_mapping.size == pairs.count*sizeof(f64), "the .f64 has %llu bytes for %llu pairs.",
+           (u64)f64_mapping.size, pairs.count);
+    f64 *f64_buffer = (f64 *)f64_mapping.data;
 
     free(temp);
 
     return (haversine_files) {
-        .json = json,
-        .f64_buffer = f64_buffer
+        .pairs = pairs,
+        .f64_buffer = f64_buffer,
+        .mapping = f64_mapping
     };
 
     bench_function_end();
 }
 
+/* NOTE(abid): Unmaps the .f64 (or the dataset), the pairs of a .json stay in their arena. */
+internal void
+haversine_files_close(haversine_files *files) {
+    platform_file_unmap(&files->mapping);
+    files->f64_buffer = NULL;
+}
+
+/* NOTE(abid): Parses the .json/.f64 pair once and keeps it as a dataset next to them, with the .f64
+ * values as the reference column and the coordinates quantized with `is_q32`. */
+internal bool
+convert_json_f64_to_dataset(char *filename, bool is_q32) {
+    bench_function_begin();
+    mem_arena *arena = arena_create(megabyte(1), terabyte(1));
+    haversine_files loaded_files = load_json_f64_files(filename, arena);
+    bool result = dataset_write(generate_filename(filename, DATASET_EXTENSION, arena), &loaded_files.pairs,
+                                loaded_files.f64_buffer, is_q32);
+    haversine_files_close(&loaded_files);
+    arena_free(arena);
+
+    return result;
+    bench_function_end();
+}
+
+/* NOTE(abid): Same as `load_json_f64_files` from the dataset of `filename`, the arrays point into
+ * the mapping and stay valid until `haversine_files_close`. */
+internal haversine_files
+load_dataset_file(char *filename, mem_arena *arena) {
+    bench_function_begin();
+    dataset data;
+    bool is_opened = dataset_open(generate_filename(filename, DATASET_EXTENSION, arena), &data);
+    assert(is_opened, "dataset could not be opened.");
+    assert(data.reference, "dataset has no reference distances.");
+    assert(!(data.header->flags & dataset_is_q32), "dataset is quantized, use `data.pairs_q32`.");
+
+    return (haversine_files) {
+        .pairs = data.pairs,
+        .f64_buffer = data.reference,
+        .mapping = data.mapping
+    };
+    bench_function_end();
+}
+
+/* NOTE(abid): Load cost of the .json/.f64 pair against its dataset, mapped and then touched by
+ * summing the distances, with and without verifying the checksum. Converts first when needed. */
+internal void
+test_dataset_load(char *filename) {
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    mem_arena *arena = arena_create(megabyte(1), terabyte(1));
+    char *dataset_filename = generate_filename(filename, DATASET_EXTENSION, arena);
+
+    dataset data;
+    if(dataset_open(dataset_filename, &data)) {
+        bool is_q32 = (data.header->flags & dataset_is_q32) != 0;
+        dataset_close(&data);
+        if(is_q32) remove(dataset_filename);
+    }
+    if(!dataset_open(dataset_filename, &data)) {
+        bool is_converted = convert_json_f64_to_dataset(filename, false);
+        assert(is_converted, "cannot convert to a dataset.");
+    } else dataset_close(&data);
+
+    u64 os_start = platform_get_os_timer();
+    haversine_files loaded_files = load_json_f64_files(filename, arena);
+    u64 os_json = platform_get_os_timer() - os_start;
+    f64 json_sum = haversine_batch_sum(&loaded_files.pairs, EARTH_RADIUS);
+
+    for(u32 is_verify = 0; is_verify < 2; ++is_verify) {
+        os_start = platform_get_os_timer();
+        bool is_opened = dataset_open(dataset_filename, &data, .is_verify = is_verify);
+        u64 os_opened = platform_get_os_timer();
+        assert(is_opened, "dataset could not be opened.");
+        f64 sum = haversine_batch_sum(&data.pairs, EARTH_RADIUS);
+        u64 os_summed = platform_get_os_timer();
+
+        usize size = data.pairs.count * sizeof(f64);
+        bool is_match = data.pairs.count == loaded_files.pairs.count &&
+                        memcmp(data.pairs.x0, loaded_files.pairs.x0, size) == 0 &&
+                        memcmp(data.pairs.y0, loaded_files.pairs.y0, size) == 0 &&
+                        memcmp(data.pairs.x1, loaded_files.pairs.x1, size) == 0 &&
+                        memcmp(data.pairs.y1, loaded_files.pairs.y1, size) == 0 &&
+                        memcmp(data.reference, loaded_files.f64_buffer, size) == 0;
+        printf("Dataset%s, Pair Count: %llu, open: %.3f ms, open+sum: %.3f ms, match: %s, sum: %s\n",
+               is_verify ? " (verified)" : "", data.pairs.count, 1000.0*(f64)(os_opened - os_start) / timer_freq,
+               1000.0*(f64)(os_summed - os_start) / timer_freq, is_match ? "yes" : "NO",
+               sum == json_sum ? "same" : "DIFFERENT");
+        dataset_close(&data);
+    }
+    printf("JSON/f64 load: %.3f ms\n", 1000.0*(f64)os_json / timer_freq);
+
+    arena_free(arena);
+}
+
+/* NOTE(abid): Distance error of quantized pairs against the .f64 reference, next to the error of the
+ * f64 pairs at the same tier, and the time of a sum over each (best of 5, already in memory). */
+internal void
+test_q32_error(char *filename) {
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    mem_arena *arena = arena_create(megabyte(1), terabyte(1));
+    haversine_files loaded_files = load_json_f64_files(filename, arena);
+    pair_soa pairs = loaded_files.pairs;
+    pair_soa_q32 pairs_q32 = pair_soa_quantize(&pairs, arena);
+
+    f64 *distances = push_array_aligned(f64, pairs.count, SIMD_ALIGNMENT, arena);
+    f64 *distances_q32 = push_array_aligned(f64, pairs.count, SIMD_ALIGNMENT, arena);
+    haversine_batch(&pairs, distances, EARTH_RADIUS);
+    haversine_batch_q32(&pairs_q32, distances_q32, EARTH_RADIUS);
+
+    printf("Pair Count: %llu, %s, %s tier\n", pairs.count, simd_level_str[kernel_simd_level_get()],
+           math_tier_str[kernel_math_tier_get()]);
+    printf("  %6s %10s %14s %14s %14s %10s\n", "coords", "bytes", "max abs (km)", "mean abs (km)",
+           "max rel", "sum ms");
+    for(u32 is_q32 = 0; is_q32 < 2; ++is_q32) {
+        f64 *values = is_q32 ? distances_q32 : distances;
+        f64 max_abs = 0, max_rel = 0;
+        exact_sum abs_sum = {0};
+        for(u64 idx = 0; idx < pairs.count; ++idx) {
+            f64 reference = loaded_files.f64_buffer[idx];
+            f64 error = fabs(values[idx] - reference);
+            if(error > max_abs) max_abs = error;
+            if(reference > 0 && error / reference > max_rel) max_rel = error / reference;
+            exact_sum_add(&abs_sum, error);
+        }
+
+        u64 best = (u64)-1;
+        for(u32 run = 0; run < 5; ++run) {
+            u64 os_start = platform_get_os_timer();
+            f64 sum = is_q32 ? haversine_batch_sum_q32(&pairs_q32, EARTH_RADIUS) : haversine_batch_sum(&pairs, EARTH_RADIUS);
+            u64 os_elapsed = platform_get_os_timer() - os_start;
+            if(os_elapsed < best) best = os_elapsed;
+            (void)sum;
+        }
+
+        printf("  %6s %10llu %14.3e %14.3e %14.3e %10.3f\n", is_q32 ? "i32" : "f64",
+               pairs.count * 4 * (is_q32 ? sizeof(i32) : sizeof(f64)), max_abs,
+               pairs.count ? exact_sum_result(&abs_sum) / (f64)pairs.count : 0.0, max_rel,
+               1000.0*(f64)best / timer_freq);
+    }
+
+    arena_free(arena);
+}
+
+internal void
+verify_result_print(verify_result *result) {
+    f64 mean_abs_error = result->pair_count ? exact_sum_result(&result->abs_error_sum) / (f64)result->pair_count : 0.0;
+    printf("Pair Count: %llu, mismatches: %llu\n", result->pair_count, result->mismatch_count);
+    printf("  max abs error: %.3e (pair %llu), max rel error: %.3e (pair %llu), mean abs error: %.3e\n",
+           result->max_abs_error, result->max_abs_idx, result->max_rel_error, result->max_rel_idx, mean_abs_error);
+
+    printf("  %12s %12s\n", "ulps", "pairs");
+    for(u32 bucket = 0; bucket < VERIFY_ULP_BUCKET_COUNT; ++bucket) {
+        if(result->ulp_histogram[bucket] == 0) continue;
+        char label[32];
+        u64 low = bucket ? 1ULL << (bucket - 1) : 0;
+        u64 high = bucket ? (1ULL << bucket) - 1 : 0;
+        if(bucket == VERIFY_ULP_BUCKET_COUNT - 1) snprintf(label, sizeof(label), "%llu+", low);
+        else if(low == high) snprintf(label, sizeof(label), "%llu", low);
+        else snprintf(label, sizeof(label), "%llu-%llu", low, high);
+        printf("  %12s %12llu\n", label, result->ulp_histogram[bucket]);
+    }
+
+    for(u32 idx = 0; idx < result->worst_count; ++idx) {
+        verify_offender *offender = result->worst + idx;
+        printf("  pair %llu: %llu ulps, stored = %.17g, calculated = %.17g\n", offender->idx, offender->ulps,
+               offender->expected, offender->computed);
+    }
+}
+
+/* NOTE(abid): Distances of the .json pairs against the mapped .f64, across every core. */
 internal void
 test_json_f64_difference(char *filename) {
-    /* NOTE(abid): Testing, using .f64, whether json parser parses values correctly. */
-    haversine_files loaded_files = load_json_f64_files(filename);
-
-    bench_block_no_return_begin(calculate_diff);
-    json_list *pairs = jp_get_dict_value(loaded_files.json, "pairs", json_list);
-    f64 difference_sum = 0;
-    for(u64 idx = 0; idx < pairs->count; ++idx) {
-        json_dict *elem = jp_get_list_elem(pairs, idx, json_dict);
-        f64 x0 = *jp_get_dict_value(elem, "x0", f64);
-        f64 x1 = *jp_get_dict_value(elem, "x1", f64);
-        f64 y0 = *jp_get_dict_value(elem, "y0", f64);
-        f64 y1 = *jp_get_dict_value(elem, "y1", f64);
-        f64 stored_value = loaded_files.f64_buffer[idx];
-        f64 calc_value = haversine(x0, y0, x1, y1, EARTH_RADIUS);
-        f64 difference = fabs(stored_value - calc_value);
-        if(difference != 0.0f) {
-            int value = 3;
-            value = 2;
+    mem_arena *pair_arena = arena_create(megabyte(1), terabyte(1));
+    haversine_files loaded_files = load_json_f64_files(filename, pair_arena);
+    thread_pool *pool = thread_pool_create(platform_cpu_get_count());
+
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    u64 os_start = platform_get_os_timer();
+    verify_result result = verify_distances(pool, &loaded_files.pairs, loaded_files.f64_buffer,
+                                             loaded_files.pairs.count, EARTH_RADIUS);
+    f64 elapsed_ms = 1000.0*(f64)(platform_get_os_timer() - os_start) / timer_freq;
+
+    haversine_files_close(&loaded_files);
+
+    verify_result_print(&result);
+    printf("Verified on %u threads in %.1f ms\n", pool->worker_count, elapsed_ms);
+
+    thread_pool_destroy(pool);
+    arena_free(pair_arena);
+}
+
+/* NOTE(abid): Max error of every math tier against the .f64 reference, to pick a tier with. */
+internal void
+test_math_tiers(char *filename) {
+    mem_arena *pair_arena = arena_create(megabyte(1), terabyte(1));
+    haversine_files loaded_files = load_json_f64_files(filename, pair_arena);
+    pair_soa pairs = loaded_files.pairs;
+    f64 *distances = push_array_aligned(f64, pairs.count, SIMD_ALIGNMENT, pair_arena);
+
+    printf("Pair Count: %llu, SIMD: %s\n", pairs.count, simd_level_str[kernel_simd_level_get()]);
+    printf("  %-8s %16s %16s %10s\n", "tier", "max abs error", "max rel error", "ns/pair");
+    for(u32 tier = 0; tier < math_tier_count; ++tier) {
+        u64 os_start = platform_get_os_timer();
+        haversine_batch(&pairs, distances, EARTH_RADIUS, .tier = tier);
+        u64 os_elapsed = platform_get_os_timer() - os_start;
+
+        f64 max_abs_error = 0;
+        f64 max_rel_error = 0;
+        for(u64 idx = 0; idx < pairs.count; ++idx) {
+            f64 stored_value = loaded_files.f64_buffer[idx];
+            f64 abs_error = fabs(stored_value - distances[idx]);
+            f64 rel_error = (stored_value != 0) ? abs_error / stored_value : abs_error;
+            if(abs_error > max_abs_error) max_abs_error = abs_error;
+            if(rel_error > max_rel_error) max_rel_error = rel_error;
+        }
+
+        f64 ns_per_pair = 1e9*(f64)os_elapsed / (f64)platform_get_os_timer_freq() / (f64)pairs.count;
+        printf("  %-8s %16.3e %16.3e %10.2f\n", math_tier_str[tier], max_abs_error, max_rel_error, ns_per_pair);
+    }
+
+    arena_free(pair_arena);
+}
+
+/* NOTE(abid): Cost of the unit vector precompute, and of the chord kernels once it is paid, next to
+ * the plain haversine. Errors are against the .f64 reference, chord-only has none to report. */
+internal void
+test_unit_vec(char *filename) {
+    mem_arena *pair_arena = arena_create(megabyte(1), terabyte(1));
+    haversine_files loaded_files = load_json_f64_files(filename, pair_arena);
+    pair_soa pairs = loaded_files.pairs;
+    f64 *distances = push_array_aligned(f64, pairs.count, SIMD_ALIGNMENT, pair_arena);
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+
+    u64 os_start = platform_get_os_timer();
+    unit_vec_soa points0 = unit_vec_soa_from_degrees(pairs.x0, pairs.y0, pairs.count, pair_arena);
+    unit_vec_soa points1 = unit_vec_soa_from_degrees(pairs.x1, pairs.y1, pairs.count, pair_arena);
+    f64 precompute_ns = 1e9*(f64)(platform_get_os_timer() - os_start) / timer_freq / (f64)pairs.count;
+
+    printf("Pair Count: %llu, SIMD: %s, Precompute: %.2f ns/pair\n", pairs.count,
+           simd_level_str[kernel_simd_level_get()], precompute_ns);
+    printf("  %-10s %-8s %16s %16s %10s\n", "kernel", "tier", "max abs error", "max rel error", "ns/pair");
+    for(u32 kernel = 0; kernel < 3; ++kernel) {
+        for(u32 tier = math_tier_precise; tier < math_tier_count; ++tier) {
+            os_start = platform_get_os_timer();
+            if(kernel == 0) haversine_batch(&pairs, distances, EARTH_RADIUS, .tier = tier);
+            else chord_batch(&points0, &points1, distances, EARTH_RADIUS, .tier = tier, .is_chord_only = (kernel == 2));
+            u64 os_elapsed = platform_get_os_timer() - os_start;
+
+            f64 max_abs_error = 0;
+            f64 max_rel_error = 0;
+            for(u64 idx = 0; kernel != 2 && idx < pairs.count; ++idx) {
+                f64 stored_value = loaded_files.f64_buffer[idx];
+                f64 abs_error = fabs(stored_value - distances[idx]);
+                f64 rel_error = (stored_value != 0) ? abs_error / stored_value : abs_error;
+                if(abs_error > max_abs_error) max_abs_error = abs_error;
+                if(rel_error > max_rel_error) max_rel_error = rel_error;
+            }
+
+            char *kernel_str[] = { "haversine", "chord", "chord-only" };
+            f64 ns_per_pair = 1e9*(f64)os_elapsed / timer_freq / (f64)pairs.count;
+            printf("  %-10s %-8s %16.3e %16.3e %10.2f\n", kernel_str[kernel], math_tier_str[tier],
+                   max_abs_error, max_rel_error, ns_per_pair);
+            /* NOTE(abid): Chord-only does not use the tier. */
+            if(kernel == 2) break;
+        }
+    }
+
+    arena_free(pair_arena);
+}
+
+typedef struct {
+    exact_sum sum;
+    u64 batch_count;
+} stream_sum_data;
+
+internal void
+stream_sum_sink(pair_soa *pairs, void *data) {
+    stream_sum_data *stream_sum = (stream_sum_data *)data;
+    haversine_batch_accumulate(pairs, EARTH_RADIUS, &stream_sum->sum,
+                               (haversine_batch_opt){ haversine_batch_opt_default });
+    ++stream_sum->batch_count;
+}
+
+/* NOTE(abid): Sums the distances of a file of any size, `chunk_size` bytes of it in memory at a time,
+ * reading on the parser's thread and then ahead of it on another. Read throughput is over the time
+ * spent reading, parse throughput over the time the parser was not waiting for data. */
+internal void
+test_stream_pairs(char *filename, usize chunk_size) {
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    for(u32 is_async = 0; is_async < 2; ++is_async) {
+        stream_sum_data stream_sum = {0};
+        jp_stream_stats stats = {0};
+        u64 pair_count = jp_stream_pairs(filename, chunk_size, stream_sum_sink, &stream_sum,
+                                         .is_async = is_async, .stats = &stats);
+
+        f64 read_mb = (f64)stats.read_bytes / (f64)megabyte(1);
+        f64 read_s = (f64)stats.read_time / timer_freq;
+        f64 parse_s = (f64)(stats.total_time - stats.wait_time) / timer_freq;
+        printf("%s, Pair Count: %llu, Batches: %llu, Chunk: %llu KB\n", is_async ? "Async" : "Sync",
+               pair_count, stream_sum.batch_count, (u64)chunk_size / 1024);
+        printf("  Sum (exact): %.12f, %.1f ms, waited %.1f ms\n", exact_sum_result(&stream_sum.sum),
+               1000.0*(f64)stats.total_time / timer_freq, 1000.0*(f64)stats.wait_time / timer_freq);
+        printf("  Read: %.1f MB/s, Parse: %.1f MB/s\n", read_s > 0 ? read_mb / read_s : 0.0,
+               parse_s > 0 ? read_mb / parse_s : 0.0);
+    }
+}
+
+/* NOTE(abid): Eager against lazy DOM when reading every `sample_stride`-th pair, the sampled values
+ * have to match. The DOMs are not freed, so keep this to files that fit in memory twice. */
+internal void
+test_lazy_load(char *filename, u64 sample_stride) {
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    f64 sums[2] = {0};
+    for(u32 is_lazy = 0; is_lazy < 2; ++is_lazy) {
+        u64 os_start = platform_get_os_timer();
+        json_dict *json = is_lazy ? jp_load_lazy(filename) : jp_load(filename);
+        u64 os_loaded = platform_get_os_timer();
+
+        json_list *pairs = jp_get_dict_value(json, "pairs", json_list);
+        for(u64 idx = 0; idx < pairs->count; idx += sample_stride) {
+            json_dict *elem = jp_get_list_elem(pairs, idx, json_dict);
+            sums[is_lazy] += jp_value_as_f64(_jp_get_dict_value(elem, "x0")) + jp_value_as_f64(_jp_get_dict_value(elem, "y0")) +
+                             jp_value_as_f64(_jp_get_dict_value(elem, "x1")) + jp_value_as_f64(_jp_get_dict_value(elem, "y1"));
+        }
+        u64 os_end = platform_get_os_timer();
+
+        printf("%-6s load: %10.3f ms, read 1/%llu: %10.3f ms, sum: %.12f\n", is_lazy ? "lazy" : "eager",
+               1000.0*(f64)(os_loaded - os_start) / timer_freq, sample_stride,
+               1000.0*(f64)(os_end - os_loaded) / timer_freq, sums[is_lazy]);
+    }
+    printf("Match: %s\n", (sums[0] == sums[1]) ? "yes" : "NO");
+}
+
+internal void
+dict_probes_walk(json_value *value, u64 *histogram, u64 *dict_count) {
+    if(value->type == jvt_dict) {
+        json_dict *dict = (json_dict *)jp_value_body(value);
+        if(dict->shape->table) jp_shape_probe_histogram(dict->shape, histogram);
+        ++*dict_count;
+        for(usize idx = 0; idx < dict->shape->count; ++idx) {
+            dict_probes_walk(jp_slot_at(jp_dict_slots(dict), idx), histogram, dict_count);
+        }
+    } else if(value->type == jvt_list) {
+        json_list *list = (json_list *)jp_value_body(value);
+        for(usize idx = 0; idx < list->count; ++idx) {
+            dict_probes_walk(jp_slot_at(jp_list_slots(list), idx), histogram, dict_count);
+        }
+    }
+}
+
+/* NOTE(abid): Probes it takes to find every key of every dict in the file, which is also what it
+ * took to insert them. */
+internal void
+test_dict_probes(char *filename) {
+    json_dict *json = jp_load(filename);
+    u64 histogram[JP_PROBE_HISTOGRAM_COUNT] = {0};
+    u64 dict_count = 1;
+    jp_shape_probe_histogram(json->shape, histogram);
+    for(usize idx = 0; idx < json->shape->count; ++idx) {
+        dict_probes_walk(jp_slot_at(jp_dict_slots(json), idx), histogram, &dict_count);
+    }
+
+    u64 key_count = 0;
+    for(u32 bucket = 0; bucket < JP_PROBE_HISTOGRAM_COUNT; ++bucket) key_count += histogram[bucket];
+    printf("Dict Count: %llu, Key Count: %llu, Max Load: %u%%\n", dict_count, key_count, JP_TABLE_MAX_LOAD_PERCENT);
+    printf("  %6s %12s %8s\n", "probes", "keys", "share");
+    for(u32 bucket = 0; bucket < JP_PROBE_HISTOGRAM_COUNT; ++bucket) {
+        printf("  %5u%s %12llu %7.2f%%\n", bucket+1, (bucket == JP_PROBE_HISTOGRAM_COUNT-1) ? "+" : " ",
+               histogram[bucket], key_count ? 100.0*(f64)histogram[bucket]/(f64)key_count : 0.0);
+    }
+}
+
+/* NOTE(abid): Cost of a dict lookup by string against one through a `jp_key` handle, reading the
+ * four keys of every pair. */
+internal void
+test_key_lookup(char *filename) {
+    json_dict *json = jp_load(filename);
+    json_list *pairs = jp_get_dict_value(json, "pairs", json_list);
+    char *keys[4] = { "x0", "y0", "x1", "y1" };
+    jp_key key_handles[4];
+    for(u32 key = 0; key < 4; ++key) key_handles[key] = jp_key_make(keys[key]);
+
+    printf("Lookup Count: %llu\n", 4*pairs->count);
+    printf("  %-8s %24s %10s\n", "lookup", "sum", "ns/lookup");
+    for(u32 is_handle = 0; is_handle < 2; ++is_handle) {
+        f64 sum = 0;
+        u64 os_start = platform_get_os_timer();
+        for(u64 idx = 0; idx < pairs->count; ++idx) {
+            json_dict *elem = jp_get_list_elem(pairs, idx, json_dict);
+            for(u32 key = 0; key < 4; ++key) {
+                json_value *value = is_handle ? _jp_get_dict_value_key(elem, key_handles + key)
+                                              : _jp_get_dict_value(elem, keys[key]);
+                sum += jp_value_as_f64(value);
+            }
+        }
+        u64 os_elapsed = platform_get_os_timer() - os_start;
+
+        f64 ns_per_lookup = 1e9*(f64)os_elapsed / (f64)platform_get_os_timer_freq() / (f64)(4*pairs->count);
+        printf("  %-8s %24.12f %10.2f\n", is_handle ? "handle" : "string", sum, ns_per_lookup);
+    }
+}
+
+/* NOTE(abid): Runs the parallel sum at 1, 2, 4, ... up to `max_thread_count` threads and reports
+ * the speedup and efficiency against one thread. */
+internal void
+test_thread_scaling(char *filename, u32 max_thread_count) {
+    if(max_thread_count == 0) max_thread_count = platform_cpu_get_count();
+
+    mem_arena *pair_arena = arena_create(megabyte(1), terabyte(1));
+    haversine_files loaded_files = load_json_f64_files(filename, pair_arena);
+    pair_soa pairs = loaded_files.pairs;
+
+    exact_sum reference_sum = {0};
+    exact_sum_add_array(&reference_sum, loaded_files.f64_buffer, pairs.count);
+    printf("Pair Count: %llu, SIMD: %s, Tier: %s\n", pairs.count,
+           simd_level_str[kernel_simd_level_get()], math_tier_str[kernel_math_tier_get()]);
+    printf("Reference Sum (exact): %.12f\n", exact_sum_result(&reference_sum));
+
+    for(u32 reduction = 0; reduction < reduction_count; ++reduction) {
+        printf("\nReduction: %s\n", reduction_mode_str[reduction]);
+        printf("  %7s %12s %24s %8s %10s %8s\n", "threads", "ms", "sum", "speedup", "efficiency", "steals");
+
+        f64 single_thread_us = 0;
+        for(u32 thread_count = 1; thread_count <= max_thread_count; ) {
+            thread_pool *pool = thread_pool_create(thread_count);
+
+            /* NOTE(abid): Best of a few runs, the first one also pays for the page faults. */
+            u64 best_us = (u64)-1;
+            f64 sum = 0;
+            for(u32 run = 0; run < 5; ++run) {
+                u64 os_start = platform_get_os_timer();
+                sum = haversine_parallel_sum(pool, &pairs, EARTH_RADIUS, .reduction = reduction);
+                u64 os_elapsed = platform_get_os_timer() - os_start;
+                if(os_elapsed < best_us) best_us = os_elapsed;
+            }
+
+            u64 steal_count = 0;
+            for(u32 idx = 0; idx < pool->worker_count; ++idx) steal_count += pool->workers[idx].stat.steal_count;
+
+            f64 elapsed_us = 1e6*(f64)best_us / (f64)platform_get_os_timer_freq();
+            if(thread_count == 1) single_thread_us = elapsed_us;
+            f64 speedup = single_thread_us / elapsed_us;
+            printf("  %7u %12.3f %24.12f %8.2f %9.1f%% %8llu\n", thread_count, elapsed_us/1000.0, sum,
+                   speedup, 100.0*speedup/thread_count, steal_count);
+
+            thread_pool_destroy(pool);
+
+            if(thread_count == max_thread_count) break;
+            thread_count = (2*thread_count > max_thread_count) ? max_thread_count : 2*thread_count;
+        }
+    }
+
+    arena_free(pair_arena);
+}
+
+/* NOTE(abid): Parses the pairs list at 1, 2, 4, ... up to `max_thread_count` threads, each result
+ * is checked against the serial parse. */
+internal void
+test_parse_scaling(char *filename, u32 max_thread_count) {
+    if(max_thread_count == 0) max_thread_count = platform_cpu_get_count();
+
+    mem_arena *pair_arena = arena_create(megabyte(1), terabyte(1));
+    pair_soa reference;
+    if(!jp_load_pairs(filename, &reference, pair_arena)) {
+        printf("%s is not in the plain pairs format.\n", filename);
+        arena_free(pair_arena);
+        return;
+    }
+    printf("Pair Count: %llu\n", reference.count);
+    printf("  %7s %12s %8s %8s\n", "threads", "ms", "speedup", "match");
+
+    f64 single_thread_us = 0;
+    for(u32 thread_count = 1; thread_count <= max_thread_count; ) {
+        thread_pool *pool = thread_pool_create(thread_count);
+
+        u64 best_us = (u64)-1;
+        bool is_match = true;
+        for(u32 run = 0; run < 3; ++run) {
+            temp_memory temp = mem_temp_begin(pair_arena);
+            pair_soa pairs;
+            u64 os_start = platform_get_os_timer();
+            bool is_parsed = jp_load_pairs_parallel(pool, filename, &pairs, pair_arena);
+            u64 os_elapsed = platform_get_os_timer() - os_start;
+            if(os_elapsed < best_us) best_us = os_elapsed;
+
+            usize size = reference.count * sizeof(f64);
+            is_match = is_match && is_parsed && pairs.count == reference.count &&
+                       memcmp(pairs.x0, reference.x0, size) == 0 && memcmp(pairs.y0, reference.y0, size) == 0 &&
+                       memcmp(pairs.x1, reference.x1, size) == 0 && memcmp(pairs.y1, reference.y1, size) == 0;
+            mem_temp_end(temp);
+        }
+
+        f64 elapsed_us = 1e6*(f64)best_us / (f64)platform_get_os_timer_freq();
+        if(thread_count == 1) single_thread_us = elapsed_us;
+        printf("  %7u %12.3f %8.2f %8s\n", thread_count, elapsed_us/1000.0, single_thread_us/elapsed_us,
+               is_match ? "yes" : "NO");
+
+        thread_pool_destroy(pool);
+
+        if(thread_count == max_thread_count) break;
+        thread_count = (2*thread_count > max_thread_count) ? max_thread_count : 2*thread_count;
+    }
+
+    arena_free(pair_arena);
+}
+
+/* NOTE(abid): Cost per element of the summation schemes, over the .f64 reference values. */
+internal void
+test_reduction_cost(char *filename) {
+    mem_arena *pair_arena = arena_create(megabyte(1), terabyte(1));
+    haversine_files loaded_files = load_json_f64_files(filename, pair_arena);
+    f64 *values = loaded_files.f64_buffer;
+    u64 count = loaded_files.pairs.count;
+
+    printf("Value Count: %llu\n", count);
+    printf("  %-10s %24s %10s\n", "scheme", "sum", "ns/value");
+    for(u32 scheme = 0; scheme < 3; ++scheme) {
+        f64 sum = 0;
+        u64 os_start = platform_get_os_timer();
+        if(scheme == 0) {
+            for(u64 idx = 0; idx < count; ++idx) sum += values[idx];
+        } else if(scheme == 1) {
+            neumaier_sum neumaier = {0};
+            for(u64 idx = 0; idx < count; ++idx) neumaier_sum_add(&neumaier, values[idx]);
+            sum = neumaier_sum_result(&neumaier);
+        } else {
+            exact_sum exact = {0};
+            exact_sum_add_array(&exact, values, count);
+            sum = exact_sum_result(&exact);
+        }
+        u64 os_elapsed = platform_get_os_timer() - os_start;
+
+        char *scheme_str[] = { "naive", "neumaier", "exact" };
+        f64 ns_per_value = 1e9*(f64)os_elapsed / (f64)platform_get_os_timer_freq() / (f64)count;
+        printf("  %-10s %24.12f %10.3f\n", scheme_str[scheme], sum, ns_per_value);
+    }
+
+    arena_free(pair_arena);
+}
+
+/* NOTE(abid): Generation throughput in MB/s of .json/.f64 written, overall and of the writes alone,
+ * with and without preallocating the files. */
+internal void
+test_generate_throughput(u64 num_pairs, u64 num_clusters, char *filename) {
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    for(u32 is_preallocate = 0; is_preallocate < 2; ++is_preallocate) {
+        generate_stats stats = {0};
+        generate_haversine_json(num_pairs, num_clusters, filename, .is_preallocate = is_preallocate, .stats = &stats);
+
+        f64 mb = (f64)(stats.json_bytes + stats.f64_bytes) / (f64)megabyte(1);
+        f64 total_s = (f64)stats.total_time / timer_freq;
+        f64 write_s = (f64)stats.write_time / timer_freq;
+        printf("%s, Pair Count: %llu, %.1f MB in %.1f ms\n", is_preallocate ? "Preallocated" : "Plain",
+               num_pairs, mb, 1000.0*total_s);
+        printf("  Overall: %.1f MB/s, Writes: %.1f MB/s (%.1f ms)\n", total_s > 0 ? mb / total_s : 0.0,
+               write_s > 0 ? mb / write_s : 0.0, 1000.0*write_s);
+    }
+}
+
+/* NOTE(abid): True if both files have the same bytes. */
+internal bool
+files_are_equal(char *filename_a, char *filename_b) {
+    platform_file_mapping a, b;
+    bool is_mapped_a = platform_file_map(filename_a, file_map_sequential, &a);
+    bool is_mapped_b = platform_file_map(filename_b, file_map_sequential, &b);
+    bool result = is_mapped_a && is_mapped_b && a.size == b.size && (a.size == 0 || memcmp(a.data, b.data, a.size) == 0);
+    platform_file_unmap(&a);
+    platform_file_unmap(&b);
+
+    return result;
+}
+
+/* NOTE(abid): Generation across 1 to `max_thread_count` threads from the same seed, the .json/.f64
+ * have to be the same bytes as those of the serial run (`filename`, the others go next to it). */
+internal void
+test_generate_scaling(u64 num_pairs, u64 num_clusters, char *filename, u32 max_thread_count) {
+    if(max_thread_count == 0) max_thread_count = platform_cpu_get_count();
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    mem_arena *arena = arena_create(kilobyte(4), megabyte(4));
+    char *threaded_filename = generate_filename(filename, "_threaded", arena);
+    char *names[2][2] = {
+        { generate_filename(filename, ".json", arena), generate_filename(filename, ".f64", arena) },
+        { generate_filename(threaded_filename, ".json", arena), generate_filename(threaded_filename, ".f64", arena) },
+    };
+
+    /* NOTE(abid): Every run starts from the same random state. */
+    rand_state start_state = __GLOBALRandState;
+    generate_stats stats = {0};
+    generate_haversine_json(num_pairs, num_clusters, filename, .stats = &stats);
+    f64 serial_ms = 1000.0*(f64)stats.total_time / timer_freq;
+    printf("Pair Count: %llu, serial: %.1f ms\n", num_pairs, serial_ms);
+    printf("  %7s %12s %8s %8s\n", "threads", "ms", "speedup", "match");
+
+    for(u32 thread_count = 1; thread_count <= max_thread_count; ) {
+        thread_pool *pool = thread_pool_create(thread_count);
+        __GLOBALRandState = start_state;
+        generate_haversine_json(num_pairs, num_clusters, threaded_filename, .stats = &stats, .pool = pool);
+        thread_pool_destroy(pool);
+
+        f64 elapsed_ms = 1000.0*(f64)stats.total_time / timer_freq;
+        bool is_match = files_are_equal(names[0][0], names[1][0]) && files_are_equal(names[0][1], names[1][1]);
+        printf("  %7u %12.1f %8.2f %8s\n", thread_count, elapsed_ms, serial_ms / elapsed_ms, is_match ? "yes" : "NO");
+
+        if(thread_count == max_thread_count) break;
+        thread_count = (2*thread_count > max_thread_count) ? max_thread_count : 2*thread_count;
+    }
+
+    /* NOTE(abid): 14 pairs in 5 clusters leaves 4 over at 2 a cluster, they all belong to the last one. */
+    generate_job job = generate_job_make(14, 5, false, arena);
+    generate_chunk chunk;
+    generate_chunk_init(&chunk, false, arena);
+    generate_chunk_fill(&job, 0, &chunk);
+    generate_cluster *last = job.clusters + job.cluster_count - 1;
+    bool is_in_last = true;
+    for(u64 idx = 5*job.pairs_per_cluster; idx < chunk.pairs.count; ++idx) {
+        is_in_last = is_in_last &&
+                     chunk.pairs.y0[idx] >= last->lat1_start && chunk.pairs.y0[idx] <= last->lat1_start + last->lat1_size &&
+                     chunk.pairs.x0[idx] >= last->lon1_start && chunk.pairs.x0[idx] <= last->lon1_start + last->lon1_size &&
+                     chunk.pairs.y1[idx] >= last->lat2_start && chunk.pairs.y1[idx] <= last->lat2_start + last->lat2_size &&
+                     chunk.pairs.x1[idx] >= last->lon2_start && chunk.pairs.x1[idx] <= last->lon2_start + last->lon2_size;
+    }
+    printf("  remainder larger than a cluster, in the last one: %s\n", is_in_last ? "yes" : "NO");
+
+    arena_free(arena);
+}
+
+/* NOTE(abid): Bulk fills of every ISA the machine has against the scalar one (bit for bit), the
+ * moments of the result against those of U[0, 1), and the time per value against `rand_range_f64`. */
+internal void
+test_rand_lanes(u64 count) {
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    mem_arena *arena = arena_create(kilobyte(4), gigabyte(1));
+    f64 *expected = push_array(f64, count, arena);
+    f64 *values = push_array(f64, count, arena);
+    char *level_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+    simd_level supported = kernel_simd_level_detect();
+    kernel_simd_level_set(simd_level_scalar);
+    rand_lanes lanes = rand_lanes_create(RandU64(), 0);
+    rand_lanes start_lanes = lanes;
+    rand_lanes_fill_unit(&lanes, expected, count);
+
+    f64 mean = 0, variance = 0;
+    for(u64 idx = 0; idx < count; ++idx) mean += expected[idx];
+    mean /= (f64)count;
+    for(u64 idx = 0; idx < count; ++idx) variance += (expected[idx] - mean)*(expected[idx] - mean);
+    variance /= (f64)count;
+    printf("Value Count: %llu, mean: %.6f (0.5), variance: %.6f (%.6f)\n", count, mean, variance, 1.0/12.0);
+
+    printf("  %8s %12s %8s\n", "level", "ns/value", "match");
+    for(simd_level level = simd_level_scalar; level <= supported; ++level) {
+        kernel_simd_level_set(level);
+        lanes = start_lanes;
+        u64 start = platform_get_os_timer();
+        rand_lanes_fill_unit(&lanes, values, count);
+        f64 elapsed = (f64)(platform_get_os_timer() - start) / timer_freq;
+        bool is_match = memcmp(expected, values, count*sizeof(f64)) == 0;
+        printf("  %8s %12.3f %8s\n", level_names[level], 1e9*elapsed / (f64)count, is_match ? "yes" : "NO");
+    }
+    kernel_simd_level_set(supported);
+
+    u64 start = platform_get_os_timer();
+    for(u64 idx = 0; idx < count; ++idx) values[idx] = rand_range_f64(0.0, 1.0);
+    f64 elapsed = (f64)(platform_get_os_timer() - start) / timer_freq;
+    printf("  %8s %12.3f\n", "serial", 1e9*elapsed / (f64)count);
+
+    arena_free(arena);
+}
+
+internal void
+pipeline_stage_print(char *name, pipeline_stage_stats *stage, u32 thread_count, f64 total_time, f64 timer_freq) {
+    f64 busy = (f64)stage->busy_time / timer_freq;
+    f64 wait = (f64)stage->wait_time / timer_freq;
+    printf("    %-8s %2u threads %9.2f Mpairs/s %9.2f Mpairs/s/thread busy %8.1f MB/s json, %5.1f%% waiting\n",
+           name, thread_count, 1e-6*(f64)stage->pair_count / total_time, 1e-6*(f64)stage->pair_count / busy,
+           1e-6*(f64)stage->json_bytes / total_time, 100.0*wait / (busy + wait));
+}
+
+/* NOTE(abid): The in-memory pipeline for every split of `thread_count` threads between producers
+ * and consumers, kernel and JSON consumers. Every run starts from the same random state, so all of
+ * them have to come to the same sum, and to the generator's reference within the kernel's error. */
+internal void
+test_pipeline(u64 num_pairs, u64 num_clusters, u32 thread_count) {
+    if(thread_count < 2) thread_count = 2;
+    f64 timer_freq = (f64)platform_get_os_timer_freq();
+    rand_state start_state = __GLOBALRandState;
+
+    pipeline_stats stats;
+    f64 expected = pipeline_run(num_pairs, num_clusters, .is_reference = true, .stats = &stats);
+    printf("Pair Count: %llu, sum: %.6f, reference: %.6f (relative %.2e)\n", num_pairs, expected,
+           stats.reference_sum, fabs(expected - stats.reference_sum) / stats.reference_sum);
+
+    char *consumer_names[] = { "kernel", "json" };
+    for(pipeline_consumer consumer = pipeline_consume_kernel; consumer <= pipeline_consume_json; ++consumer) {
+        for(u32 producer_count = 1; producer_count < thread_count; ++producer_count) {
+            u32 consumer_count = thread_count - producer_count;
+            __GLOBALRandState = start_state;
+            f64 sum = pipeline_run(num_pairs, num_clusters, .producer_count = producer_count,
+                                   .consumer_count = consumer_count, .consumer = consumer, .stats = &stats);
+
+            f64 total_time = (f64)stats.total_time / timer_freq;
+            printf("  %s consumers, %.1f ms, match: %s\n", consumer_names[consumer], 1000.0*total_time,
+                   (sum == expected) ? "yes" : "NO");
+            pipeline_stage_print("produce", &stats.produce, producer_count, total_time, timer_freq);
+            pipeline_stage_print("consume", &stats.consume, consumer_count, total_time, timer_freq);
         }
-        difference_sum += difference;
-        // printf("%llu. stored = %f, calculated = %f, difference = %f\n",
-        //        idx+1, stored_value, calc_value, difference);
     }
-    bench_block_no_return_end(calculate_diff);
-    // printf("\nTotal difference: %f\n", difference_sum);
 }
 
 internal void
@@ -102,8 +818,8 @@ generate_and_check_difference(u64 num_pairs, u64 num_clusters, char *filename, u
 #if 1
 i32 main(i32 argc, char* argv[]) {
 
-    if(argc != 5) {
-        printf("Usage: [seed] [number of pairs] [number of clusters] [file name]\n");
+    if(argc != 5 && argc != 6) {
+        printf("Usage: [seed] [number of pairs] [number of clusters] [file name] [thread count (optional, 0 = all)]\n");
         return -1;
     }
 
@@ -117,7 +833,8 @@ i32 main(i32 argc, char* argv[]) {
     bench_begin();
 
     // generate_haversine_json(number_pairs, num_clusters, filename);
-    test_json_f64_difference(filename);
+    if(argc == 6) test_thread_scaling(filename, (u32)atoi(argv[5]));
+    else test_json_f64_difference(filename);
 
     bench_end();
 
@@ -0,0 +1,175 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 18:41:09 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+/* NOTE(abid): Generator and consumers in one process with a ring of chunks in between, so the
+ * kernel and the parser can be loaded at rates no disk keeps up with. Needs the generator, the
+ * kernels and the streaming parser, so it comes after all three. */
+#include "pipeline.h"
+
+/* NOTE(abid): Parses the JSON of a generated chunk in place into `pairs`, using the streaming parser's
+ * pair routine. The text is ",\n\t{...}" per pair (no separator before the very first one). */
+internal void
+pipeline_parse_chunk(generate_chunk *chunk, pair_soa *pairs) {
+    buffer text = { .str = chunk->json, .length = chunk->json_size };
+    for(u64 idx = 0; idx < chunk->pairs.count; ++idx) {
+        buffer_consume_ignores(&text);
+        if(buffer_char(&text) == ',') {
+            buffer_consume(&text);
+            buffer_consume_ignores(&text);
+        }
+        parse_assert(buffer_char(&text) == '{', "generated chunk is not a list of pair dictionaries");
+        jp_stream_parse_pair(&text, pairs, idx);
+        buffer_consume(&text); /* consume } */
+    }
+    pairs->count = chunk->pairs.count;
+}
+
+internal PLATFORM_THREAD_PROC(pipeline_producer_proc) {
+    pipeline_worker *worker = (pipeline_worker *)param;
+    pipeline *pipe = worker->pipe;
+    while(true) {
+        u64 chunk_idx = interlocked_add_u64(&pipe->next_produce, 1);
+        if(chunk_idx >= pipe->chunk_count) break;
+        pipeline_slot *slot = pipe->slots + chunk_idx % pipe->slot_count;
+
+        u64 os_start = platform_get_os_timer();
+        platform_semaphore_wait(&slot->is_free);
+        u64 os_ready = platform_get_os_timer();
+
+        slot->chunk_idx = chunk_idx;
+        generate_chunk_fill(&pipe->job, chunk_idx, &slot->chunk);
+        if(pipe->job.is_reference) {
+            f64 sum = 0;
+            for(u64 idx = 0; idx < slot->chunk.pairs.count; ++idx) sum += slot->chunk.distances[idx];
+            pipe->reference_sums[chunk_idx] = sum;
+        }
+
+        worker->stats.wait_time += os_ready - os_start;
+        worker->stats.busy_time += platform_get_os_timer() - os_ready;
+        worker->stats.chunk_count += 1;
+        worker->stats.pair_count += slot->chunk.pairs.count;
+        worker->stats.json_bytes += slot->chunk.json_size;
+        platform_semaphore_post(&slot->is_full);
+    }
+
+    return 0;
+}
+
+internal PLATFORM_THREAD_PROC(pipeline_consumer_proc) {
+    pipeline_worker *worker = (pipeline_worker *)param;
+    pipeline *pipe = worker->pipe;
+    while(true) {
+        u64 chunk_idx = interlocked_add_u64(&pipe->next_consume, 1);
+        if(chunk_idx >= pipe->chunk_count) break;
+        pipeline_slot *slot = pipe->slots + chunk_idx % pipe->slot_count;
+
+        u64 os_start = platform_get_os_timer();
+        platform_semaphore_wait(&slot->is_full);
+        u64 os_ready = platform_get_os_timer();
+
+        pair_soa *pairs = &slot->chunk.pairs;
+        if(pipe->consumer == pipeline_consume_json) {
+            pipeline_parse_chunk(&slot->chunk, &slot->parsed);
+            worker->stats.json_bytes += slot->chunk.json_size;
+            pairs = &slot->parsed;
+        }
+        /* NOTE(abid): The chunk in the slot, which may not be the one claimed (see `pipeline`). */
+        pipe->chunk_sums[slot->chunk_idx] = haversine_batch_sum(pairs, pipe->earth_radius);
+
+        worker->stats.wait_time += os_ready - os_start;
+        worker->stats.busy_time += platform_get_os_timer() - os_ready;
+        worker->stats.chunk_count += 1;
+        worker->stats.pair_count += pairs->count;
+        platform_semaphore_post(&slot->is_free);
+    }
+
+    return 0;
+}
+
+internal void
+pipeline_stage_stats_add(pipeline_stage_stats *dest, pipeline_stage_stats *src) {
+    dest->chunk_count += src->chunk_count;
+    dest->pair_count += src->pair_count;
+    dest->json_bytes += src->json_bytes;
+    dest->busy_time += src->busy_time;
+    dest->wait_time += src->wait_time;
+}
+
+/* NOTE(abid): Generates `number_pairs` pairs as `generate_haversine_json` would (same seed, same
+ * pairs) on `producer_count` threads, and sums their distances with the kernel on `consumer_count`
+ * others, nothing touches the disk. Producers block once every slot is full, consumers once every
+ * slot is empty. Returns the sum, which is the same for any thread and slot counts. With
+ * `is_reference` the generator computes the distances with `haversine()` too, for checking, and
+ * that is part of the producers' time. */
+#define pipeline_run(number_pairs, num_clusters, ...) \
+    __pipeline_run_impl(number_pairs, num_clusters, (pipeline_opt){ pipeline_opt_default, __VA_ARGS__ })
+internal f64
+__pipeline_run_impl(u64 number_pairs, u64 num_clusters, pipeline_opt opt) {
+    bench_function_begin();
+    u64 os_start = platform_get_os_timer();
+
+    assert(opt.producer_count > 0 && opt.consumer_count > 0, "a pipeline needs a thread per stage at least.");
+    if(opt.slot_count == 0) opt.slot_count = 2*(opt.producer_count + opt.consumer_count);
+
+    mem_arena *temp_arena = arena_create(kilobyte(1), gigabyte(10));
+    bool is_json = opt.consumer == pipeline_consume_json;
+    pipeline pipe = {
+        .job = generate_job_make(number_pairs, num_clusters, is_json, temp_arena),
+        .slot_count = opt.slot_count,
+        .chunk_count = (number_pairs + GENERATE_CHUNK_PAIRS - 1) / GENERATE_CHUNK_PAIRS,
+        .consumer = opt.consumer,
+        .earth_radius = EARTH_RADIUS,
+    };
+    pipe.job.is_reference = opt.is_reference;
+    pipe.chunk_sums = push_array(f64, pipe.chunk_count, temp_arena);
+    if(opt.is_reference) pipe.reference_sums = push_array(f64, pipe.chunk_count, temp_arena);
+
+    pipe.slots = push_array_aligned(pipeline_slot, pipe.slot_count, SIMD_ALIGNMENT, temp_arena);
+    for(u32 slot_idx = 0; slot_idx < pipe.slot_count; ++slot_idx) {
+        pipeline_slot *slot = pipe.slots + slot_idx;
+        generate_chunk_init(&slot->chunk, is_json, temp_arena);
+        if(is_json) slot->parsed = pair_soa_create(GENERATE_CHUNK_PAIRS, temp_arena);
+        platform_semaphore_init(&slot->is_free);
+        platform_semaphore_init(&slot->is_full);
+        platform_semaphore_post(&slot->is_free);
+    }
+
+    u32 worker_count = opt.producer_count + opt.consumer_count;
+    pipeline_worker *workers = push_array_aligned(pipeline_worker, worker_count, SIMD_ALIGNMENT, temp_arena);
+    for(u32 worker_idx = 0; worker_idx < worker_count; ++worker_idx) {
+        pipeline_worker *worker = workers + worker_idx;
+        *worker = (pipeline_worker){ .pipe = &pipe };
+        bool is_producer = worker_idx < opt.producer_count;
+        worker->thread = platform_thread_create(is_producer ? pipeline_producer_proc : pipeline_consumer_proc, worker);
+    }
+
+    pipeline_stats stats = {0};
+    for(u32 worker_idx = 0; worker_idx < worker_count; ++worker_idx) {
+        pipeline_worker *worker = workers + worker_idx;
+        platform_thread_join(worker->thread);
+        pipeline_stage_stats_add((worker_idx < opt.producer_count) ? &stats.produce : &stats.consume, &worker->stats);
+    }
+
+    f64 result = 0;
+    for(u64 chunk_idx = 0; chunk_idx < pipe.chunk_count; ++chunk_idx) {
+        result += pipe.chunk_sums[chunk_idx];
+        if(opt.is_reference) stats.reference_sum += pipe.reference_sums[chunk_idx];
+    }
+
+    for(u32 slot_idx = 0; slot_idx < pipe.slot_count; ++slot_idx) {
+        platform_semaphore_destroy(&pipe.slots[slot_idx].is_free);
+        platform_semaphore_destroy(&pipe.slots[slot_idx].is_full);
+    }
+    arena_free(temp_arena);
+    stats.total_time = platform_get_os_timer() - os_start;
+    if(opt.stats) *opt.stats = stats;
+
+    return result;
+
+    bench_function_end();
+}
@@ -0,0 +1,85 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 18:41:09 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#if !defined(PIPELINE_H)
+
+/* NOTE(abid): What the consumers of a pipeline do with a chunk, the kernel straight on the generated
+ * pairs, or the streaming parser on the chunk's JSON first and the kernel on what it parsed. */
+typedef enum {
+    pipeline_consume_kernel,
+    pipeline_consume_json,
+} pipeline_consumer;
+
+/* NOTE(abid): One stage, summed over its threads. Busy is the time spent on chunks, waiting is the
+ * time blocked on the ring: for the producers that is back-pressure (no free slot), for the
+ * consumers starvation (no full one). Times are OS timer ticks. */
+typedef struct {
+    u64 chunk_count;
+    u64 pair_count;
+    u64 json_bytes;
+    u64 busy_time;
+    u64 wait_time;
+} pipeline_stage_stats;
+
+typedef struct {
+    pipeline_stage_stats produce;
+    pipeline_stage_stats consume;
+    u64 total_time;
+    f64 reference_sum; // Of the distances the generator computed, with `is_reference`.
+} pipeline_stats;
+
+/* NOTE(abid): A chunk of the ring. `is_free` and `is_full` are posted once per chunk that passes
+ * through, by the consumer and the producer of it. */
+typedef struct {
+    u64 chunk_idx; // Of the chunk in `chunk`, set by its producer.
+    generate_chunk chunk;
+    pair_soa parsed; // What the JSON consumer parsed out of `chunk`.
+    platform_semaphore is_free;
+    platform_semaphore is_full;
+} pipeline_slot;
+
+/* NOTE(abid): Chunk `idx` goes through slot `idx % slot_count`. The semaphores only count chunks
+ * in and out of a slot, they do not order them: a thread that stalls after claiming chunk `k` can
+ * be overtaken on its slot by whoever claimed `k + slot_count`, so a consumer may get either. It
+ * goes by the slot's `chunk_idx`, not by the chunk it claimed, and every chunk is still consumed
+ * once since as many consumers wait on a slot as chunks go through it. */
+typedef struct {
+    generate_job job;
+    pipeline_slot *slots;
+    u32 slot_count;
+    u64 chunk_count;
+    pipeline_consumer consumer;
+    f64 earth_radius;
+
+    volatile u64 next_produce;
+    volatile u64 next_consume;
+    f64 *chunk_sums; // Per chunk, added up in order at the end so the sum does not depend on scheduling.
+    f64 *reference_sums; // Per chunk, with `job.is_reference`.
+} pipeline;
+
+typedef struct {
+    pipeline *pipe;
+    platform_thread thread;
+    pipeline_stage_stats stats;
+} pipeline_worker;
+
+/* NOTE(abid): A `slot_count` of 0 is twice the number of threads, fewer slots than threads works
+ * but leaves some of them waiting. */
+typedef struct {
+    u32 producer_count;
+    u32 consumer_count;
+    u32 slot_count;
+    pipeline_consumer consumer;
+    bool is_reference;
+    pipeline_stats *stats;
+} pipeline_opt;
+#define pipeline_opt_default .producer_count = 1, .consumer_count = 1, .slot_count = 0, \
+                             .consumer = pipeline_consume_kernel, .is_reference = false, .stats = NULL
+
+#define PIPELINE_H
+#endif
@@ -28,14 +28,51 @@ rand_seed(u64 Seed) {
     __GLOBALRandState.V *= 2685821657736338717LL;
 }
 
-inline internal u64 
-RandU64() {
-    __GLOBALRandState.V ^= __GLOBALRandState.V >> 21;
-    __GLOBALRandState.V ^= __GLOBALRandState.V << 35;
-    __GLOBALRandState.V ^= __GLOBALRandState.V >> 4;
-    return __GLOBALRandState.V * 2685821657736338717LL;
+/* NOTE(abid): Substreams. Any number of independent generators from one seed, the state of stream
+ * `stream_idx` is a hash of the two (the SplitMix64 finalizer), so it can be made by any thread in
+ * any order, and work split by stream comes out the same however it is scheduled. */
+inline internal u64
+rand_mix_u64(u64 value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+inline internal rand_state
+rand_stream(u64 seed, u64 stream_idx) {
+    rand_state result = { .V = rand_mix_u64(seed ^ rand_mix_u64(stream_idx)) };
+    /* NOTE(abid): Zero is the one state xorshift never leaves. */
+    if(result.V == 0) result.V = 4101842887655102017LL;
+    return result;
+}
+
+inline internal u64
+rand_stream_u64(rand_state *state) {
+    state->V ^= state->V >> 21;
+    state->V ^= state->V << 35;
+    state->V ^= state->V >> 4;
+    return state->V * 2685821657736338717LL;
+}
+
+/* NOTE(abid): Range [Min, Max] */
+inline internal f64
+rand_stream_range_f64(rand_state *state, f64 Min, f64 Max) {
+    return Min + 5.42101086242752217e-20 * (f64)rand_stream_u64(state) * (Max - Min);
 }
 
+/* NOTE(abid): Lanes of substream `stream_idx`, each lane a substream of that one's first state. */
+internal rand_lanes
+rand_lanes_create(u64 seed, u64 stream_idx) {
+    rand_lanes result;
+    u64 lane_seed = rand_stream(seed, stream_idx).V;
+    for(u32 lane = 0; lane < RAND_LANE_COUNT; ++lane) result.states[lane] = rand_stream(lane_seed, lane).V;
+    return result;
+}
+
+inline internal u64 
+RandU64() { return rand_stream_u64(&__GLOBALRandState); }
+
 /* NOTE(abid): Range in [Min, Max) */
 /* TODO(abid): Get rid of modulus in here (faster). */
 inline internal u64
@@ -17,5 +17,19 @@ typedef struct {
     u64 U16Reserves;
 } rand_state;
 
+/* NOTE(abid): Independent xorshift* generators stepped side by side, one per SIMD lane (a register
+ * of them on AVX512, two on AVX2, four on SSE2). Bulk fills hand out values round by round, value
+ * `idx` of a fill from lane `idx % RAND_LANE_COUNT`, so the output is the same on every ISA. */
+#define RAND_LANE_COUNT 8
+
+typedef struct {
+    u64 states[RAND_LANE_COUNT];
+} rand_lanes;
+
+/* NOTE(abid): Dispatched per ISA, so defined in kernel.c with the other SIMD routines. A fill takes
+ * whole rounds from the lanes, values of a round past `count` are dropped. */
+internal void rand_lanes_fill_unit(rand_lanes *lanes, f64 *dest, u64 count);
+internal void rand_lanes_fill_range_f64(rand_lanes *lanes, f64 *dest, u64 count, f64 min, f64 max);
+
 #define RANDOM_H
 #endif
@@ -0,0 +1,127 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 15:27:12 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#include "reduce.h"
+
+/* NOTE(abid): Propagates the carries, leaving every digit but the top one in [0, 2^32). The top
+ * digit carries the sign. */
+internal void
+exact_sum_normalize(exact_sum *sum) {
+    for(u32 idx = 0; idx < EXACT_SUM_DIGIT_COUNT - 1; ++idx) {
+        i64 carry = sum->digits[idx] >> 32; /* NOTE(abid): Arithmetic shift, so this floors. */
+        sum->digits[idx] -= carry * ((i64)1 << 32);
+        sum->digits[idx + 1] += carry;
+    }
+    sum->adds_since_normalize = 0;
+}
+
+inline internal void
+exact_sum_add(exact_sum *sum, f64 value) {
+    u64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    u32 biased_exponent = (u32)(bits >> 52) & 0x7FF;
+    u64 mantissa = bits & 0xFFFFFFFFFFFFFULL;
+
+    if(biased_exponent == 0x7FF) {
+        sum->special += value;
+        return;
+    }
+    /* NOTE(abid): Subnormals have the same scale as the smallest normal, minus the implicit 1. */
+    if(biased_exponent == 0) biased_exponent = 1;
+    else mantissa |= 1ULL << 52;
+
+    /* NOTE(abid): value = mantissa * 2^(biased_exponent - 1075), so in our units the mantissa
+     * sits at bit `biased_exponent - 1` and spans at most three digits. */
+    u32 position = biased_exponent - 1;
+    u32 digit = position / 32;
+    u32 shift = position % 32;
+    i64 part0 = (i64)((mantissa << shift) & 0xFFFFFFFF);
+    i64 part1 = (i64)((mantissa >> (32 - shift)) & 0xFFFFFFFF);
+    i64 part2 = (i64)((mantissa >> 1) >> (63 - shift));
+    if(bits >> 63) {
+        sum->digits[digit] -= part0;
+        sum->digits[digit + 1] -= part1;
+        sum->digits[digit + 2] -= part2;
+    } else {
+        sum->digits[digit] += part0;
+        sum->digits[digit + 1] += part1;
+        sum->digits[digit + 2] += part2;
+    }
+
+    if(++sum->adds_since_normalize == EXACT_SUM_NORMALIZE_INTERVAL) exact_sum_normalize(sum);
+}
+
+internal void
+exact_sum_add_array(exact_sum *sum, f64 *values, u64 count) {
+    for(u64 idx = 0; idx < count; ++idx) exact_sum_add(sum, values[idx]);
+}
+
+/* NOTE(abid): dest += src, exactly. */
+internal void
+exact_sum_merge(exact_sum *dest, exact_sum *src) {
+    exact_sum_normalize(dest);
+    exact_sum_normalize(src);
+    for(u32 idx = 0; idx < EXACT_SUM_DIGIT_COUNT; ++idx) dest->digits[idx] += src->digits[idx];
+    exact_sum_normalize(dest);
+    dest->special += src->special;
+}
+
+/* NOTE(abid): The exact sum rounded (to nearest, ties to even) to an f64, this is the only
+ * rounding that ever happens. */
+internal f64
+exact_sum_result(exact_sum *sum) {
+    if(sum->special != 0.0 || sum->special != sum->special) return sum->special;
+
+    exact_sum value = *sum;
+    exact_sum_normalize(&value);
+
+    bool is_negative = value.digits[EXACT_SUM_DIGIT_COUNT - 1] < 0;
+    if(is_negative) {
+        for(u32 idx = 0; idx < EXACT_SUM_DIGIT_COUNT; ++idx) value.digits[idx] = -value.digits[idx];
+        exact_sum_normalize(&value);
+    }
+
+    i32 top = EXACT_SUM_DIGIT_COUNT - 1;
+    while(top >= 0 && value.digits[top] == 0) --top;
+    if(top < 0) return 0.0;
+
+    /* NOTE(abid): Gather the top 64 bits into `mantissa`, everything below only matters as a
+     * sticky bit for the rounding. */
+    u64 high = (u64)value.digits[top];
+    u64 mid = (top >= 1) ? (u64)value.digits[top - 1] : 0;
+    u64 low = (top >= 2) ? (u64)value.digits[top - 2] : 0;
+    bool is_sticky = false;
+    for(i32 idx = top - 3; idx >= 0 && !is_sticky; --idx) is_sticky = value.digits[idx] != 0;
+
+    u64 mantissa = (high << 32) | mid;
+    u32 leading_zeros = count_leading_zeros_u64(mantissa);
+    if(leading_zeros) {
+        mantissa = (mantissa << leading_zeros) | (low >> (32 - leading_zeros));
+        is_sticky |= ((low << leading_zeros) & 0xFFFFFFFF) != 0;
+    } else is_sticky |= low != 0;
+
+    /* NOTE(abid): Halve to fit a signed convert, the dropped bit folds into the sticky bit. The
+     * sticky bit in bit 0 is far below the f64 rounding point, so the convert rounds correctly. */
+    is_sticky |= mantissa & 1;
+    mantissa = (mantissa >> 1) | (u64)is_sticky;
+    i32 exponent = 32*(top - 1) - (i32)leading_zeros + 1 - 1074;
+
+    f64 result = ldexp((f64)(i64)mantissa, exponent);
+    return is_negative ? -result : result;
+}
+
+inline internal void
+neumaier_sum_add(neumaier_sum *sum, f64 value) {
+    f64 total = sum->sum + value;
+    if(fabs(sum->sum) >= fabs(value)) sum->compensation += (sum->sum - total) + value;
+    else sum->compensation += (value - total) + sum->sum;
+    sum->sum = total;
+}
+
+inline internal f64
+neumaier_sum_result(neumaier_sum *sum) { return sum->sum + sum->compensation; }
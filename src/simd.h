@@ -0,0 +1,261 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 10:04:12 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+/* NOTE(abid): This header has two halves. The guarded half below is the usual one-time stuff,
+ * the unguarded half at the bottom is re-included once per instruction set with `SIMD_ISA` set,
+ * and (re)defines the `wide_*` vocabulary that the templated routines (simd_math.c,
+ * simd_kernel.c) are written in. That way each routine is written once and instantiated for
+ * every ISA we dispatch to. - 18.Oct.2026 */
+
+#if !defined(SIMD_H)
+
+#if PLT_WIN
+#include <intrin.h>
+#elif PLT_LINUX
+#include <immintrin.h>
+#endif
+
+#define SIMD_ISA_SCALAR 0
+#define SIMD_ISA_SSE2   1
+#define SIMD_ISA_AVX2   2
+#define SIMD_ISA_AVX512 3
+
+/* NOTE(abid): Wide enough for every ISA, used for arrays that are handed to the kernels. */
+#define SIMD_ALIGNMENT 64
+
+/* NOTE(abid): msvc lets us use any intrinsic anywhere, gcc/clang need the function marked. */
+#if PLT_WIN
+#define target_sse2
+#define target_avx2
+#define target_avx512
+#elif PLT_LINUX
+#define target_sse2 __attribute__((target("sse2")))
+#define target_avx2 __attribute__((target("avx2,fma")))
+#define target_avx512 __attribute__((target("avx512f")))
+#endif
+
+/* NOTE(abid): Bit casts for the scalar instantiation. */
+typedef union { f64 f; u64 u; } simd_f64_bits;
+inline internal u64 simd_u64_from_f64(f64 value) { simd_f64_bits bits = { .f = value }; return bits.u; }
+inline internal f64 simd_f64_from_u64(u64 value) { simd_f64_bits bits = { .u = value }; return bits.f; }
+
+#define __wide_fn_paste(name, suffix) name ## _ ## suffix
+#define __wide_fn_expand(name, suffix) __wide_fn_paste(name, suffix)
+
+#define SIMD_H
+#endif
+
+#if defined(SIMD_ISA)
+
+#undef SIMD_WIDTH
+#undef wide_suffix
+#undef wide_target
+#undef wide_f64
+#undef wide_u64
+#undef wide_set1
+#undef wide_set1_u64
+#undef wide_zero
+#undef wide_load
+#undef wide_load_i32
+#undef wide_store
+#undef wide_add
+#undef wide_sub
+#undef wide_mul
+#undef wide_div
+#undef wide_sqrt
+#undef wide_mul_add
+#undef wide_and
+#undef wide_or
+#undef wide_xor
+#undef wide_andnot
+#undef wide_cmp_lt
+#undef wide_select
+#undef wide_reduce_add
+#undef wide_reduce_add_sse
+#undef wide_as_u64
+#undef wide_as_f64
+#undef wide_add_u64
+#undef wide_sub_u64
+#undef wide_and_u64
+#undef wide_shl_u64
+#undef wide_shr_u64
+#undef wide_xor_u64
+#undef wide_or_u64
+#undef wide_load_u64
+#undef wide_store_u64
+#undef wide_mul_u32_u64
+
+#if SIMD_ISA == SIMD_ISA_SCALAR
+
+#define SIMD_WIDTH 1
+#define wide_suffix scalar
+#define wide_target
+#define wide_f64 f64
+#define wide_u64 u64
+#define wide_set1(a) (f64)(a)
+#define wide_set1_u64(a) (u64)(a)
+#define wide_zero() 0.0
+#define wide_load(ptr) (*(ptr))
+#define wide_load_i32(ptr) (f64)(*(ptr))
+#define wide_store(ptr, a) (*(ptr) = (a))
+#define wide_add(a, b) ((a) + (b))
+#define wide_sub(a, b) ((a) - (b))
+#define wide_mul(a, b) ((a) * (b))
+#define wide_div(a, b) ((a) / (b))
+#define wide_sqrt(a) sqrt(a)
+#define wide_mul_add(a, b, c) ((a)*(b) + (c))
+#define wide_as_u64(a) simd_u64_from_f64(a)
+#define wide_as_f64(a) simd_f64_from_u64(a)
+#define wide_and(a, b) simd_f64_from_u64(simd_u64_from_f64(a) & simd_u64_from_f64(b))
+#define wide_or(a, b) simd_f64_from_u64(simd_u64_from_f64(a) | simd_u64_from_f64(b))
+#define wide_xor(a, b) simd_f64_from_u64(simd_u64_from_f64(a) ^ simd_u64_from_f64(b))
+#define wide_andnot(a, b) simd_f64_from_u64(~simd_u64_from_f64(a) & simd_u64_from_f64(b))
+#define wide_cmp_lt(a, b) simd_f64_from_u64(((a) < (b)) ? ~0ULL : 0ULL)
+#define wide_select(mask, a, b) (simd_u64_from_f64(mask) ? (a) : (b))
+#define wide_reduce_add(a) (a)
+#define wide_add_u64(a, b) ((a) + (b))
+#define wide_sub_u64(a, b) ((a) - (b))
+#define wide_and_u64(a, b) ((a) & (b))
+#define wide_shl_u64(a, count) ((a) << (count))
+#define wide_shr_u64(a, count) ((a) >> (count))
+#define wide_xor_u64(a, b) ((a) ^ (b))
+#define wide_or_u64(a, b) ((a) | (b))
+#define wide_load_u64(ptr) (*(ptr))
+#define wide_store_u64(ptr, a) (*(ptr) = (a))
+#define wide_mul_u32_u64(a, b) (((a) & 0xffffffffULL) * ((b) & 0xffffffffULL))
+
+#elif SIMD_ISA == SIMD_ISA_SSE2
+
+#define SIMD_WIDTH 2
+#define wide_suffix sse2
+#define wide_target target_sse2
+#define wide_f64 __m128d
+#define wide_u64 __m128i
+#define wide_set1(a) _mm_set1_pd(a)
+#define wide_set1_u64(a) _mm_set1_epi64x(a)
+#define wide_zero() _mm_setzero_pd()
+#define wide_load(ptr) _mm_loadu_pd(ptr)
+#define wide_load_i32(ptr) _mm_cvtepi32_pd(_mm_loadl_epi64((__m128i *)(ptr)))
+#define wide_store(ptr, a) _mm_storeu_pd(ptr, a)
+#define wide_add(a, b) _mm_add_pd(a, b)
+#define wide_sub(a, b) _mm_sub_pd(a, b)
+#define wide_mul(a, b) _mm_mul_pd(a, b)
+#define wide_div(a, b) _mm_div_pd(a, b)
+#define wide_sqrt(a) _mm_sqrt_pd(a)
+#define wide_mul_add(a, b, c) _mm_add_pd(_mm_mul_pd(a, b), c)
+#define wide_as_u64(a) _mm_castpd_si128(a)
+#define wide_as_f64(a) _mm_castsi128_pd(a)
+#define wide_and(a, b) _mm_and_pd(a, b)
+#define wide_or(a, b) _mm_or_pd(a, b)
+#define wide_xor(a, b) _mm_xor_pd(a, b)
+#define wide_andnot(a, b) _mm_andnot_pd(a, b)
+#define wide_cmp_lt(a, b) _mm_cmplt_pd(a, b)
+#define wide_select(mask, a, b) _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b))
+#define wide_reduce_add(a) _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)))
+#define wide_add_u64(a, b) _mm_add_epi64(a, b)
+#define wide_sub_u64(a, b) _mm_sub_epi64(a, b)
+#define wide_and_u64(a, b) _mm_and_si128(a, b)
+#define wide_shl_u64(a, count) _mm_slli_epi64(a, count)
+#define wide_shr_u64(a, count) _mm_srli_epi64(a, count)
+#define wide_xor_u64(a, b) _mm_xor_si128(a, b)
+#define wide_or_u64(a, b) _mm_or_si128(a, b)
+#define wide_load_u64(ptr) _mm_loadu_si128((__m128i *)(ptr))
+#define wide_store_u64(ptr, a) _mm_storeu_si128((__m128i *)(ptr), a)
+#define wide_mul_u32_u64(a, b) _mm_mul_epu32(a, b)
+
+#elif SIMD_ISA == SIMD_ISA_AVX2
+
+#define SIMD_WIDTH 4
+#define wide_suffix avx2
+#define wide_target target_avx2
+#define wide_f64 __m256d
+#define wide_u64 __m256i
+#define wide_set1(a) _mm256_set1_pd(a)
+#define wide_set1_u64(a) _mm256_set1_epi64x(a)
+#define wide_zero() _mm256_setzero_pd()
+#define wide_load(ptr) _mm256_loadu_pd(ptr)
+#define wide_load_i32(ptr) _mm256_cvtepi32_pd(_mm_loadu_si128((__m128i *)(ptr)))
+#define wide_store(ptr, a) _mm256_storeu_pd(ptr, a)
+#define wide_add(a, b) _mm256_add_pd(a, b)
+#define wide_sub(a, b) _mm256_sub_pd(a, b)
+#define wide_mul(a, b) _mm256_mul_pd(a, b)
+#define wide_div(a, b) _mm256_div_pd(a, b)
+#define wide_sqrt(a) _mm256_sqrt_pd(a)
+#define wide_mul_add(a, b, c) _mm256_fmadd_pd(a, b, c)
+#define wide_as_u64(a) _mm256_castpd_si256(a)
+#define wide_as_f64(a) _mm256_castsi256_pd(a)
+#define wide_and(a, b) _mm256_and_pd(a, b)
+#define wide_or(a, b) _mm256_or_pd(a, b)
+#define wide_xor(a, b) _mm256_xor_pd(a, b)
+#define wide_andnot(a, b) _mm256_andnot_pd(a, b)
+#define wide_cmp_lt(a, b) _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define wide_select(mask, a, b) _mm256_blendv_pd(b, a, mask)
+#define wide_reduce_add(a) \
+    wide_reduce_add_sse(_mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1)))
+#define wide_reduce_add_sse(a) _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)))
+#define wide_add_u64(a, b) _mm256_add_epi64(a, b)
+#define wide_sub_u64(a, b) _mm256_sub_epi64(a, b)
+#define wide_and_u64(a, b) _mm256_and_si256(a, b)
+#define wide_shl_u64(a, count) _mm256_slli_epi64(a, count)
+#define wide_shr_u64(a, count) _mm256_srli_epi64(a, count)
+#define wide_xor_u64(a, b) _mm256_xor_si256(a, b)
+#define wide_or_u64(a, b) _mm256_or_si256(a, b)
+#define wide_load_u64(ptr) _mm256_loadu_si256((__m256i *)(ptr))
+#define wide_store_u64(ptr, a) _mm256_storeu_si256((__m256i *)(ptr), a)
+#define wide_mul_u32_u64(a, b) _mm256_mul_epu32(a, b)
+
+#elif SIMD_ISA == SIMD_ISA_AVX512
+
+/* NOTE(abid): Only AVX-512F is assumed, so the f64 bitwise ops (which are DQ) go through the
+ * integer domain. */
+#define SIMD_WIDTH 8
+#define wide_suffix avx512
+#define wide_target target_avx512
+#define wide_f64 __m512d
+#define wide_u64 __m512i
+#define wide_set1(a) _mm512_set1_pd(a)
+#define wide_set1_u64(a) _mm512_set1_epi64(a)
+#define wide_zero() _mm512_setzero_pd()
+#define wide_load(ptr) _mm512_loadu_pd(ptr)
+#define wide_load_i32(ptr) _mm512_cvtepi32_pd(_mm256_loadu_si256((__m256i *)(ptr)))
+#define wide_store(ptr, a) _mm512_storeu_pd(ptr, a)
+#define wide_add(a, b) _mm512_add_pd(a, b)
+#define wide_sub(a, b) _mm512_sub_pd(a, b)
+#define wide_mul(a, b) _mm512_mul_pd(a, b)
+#define wide_div(a, b) _mm512_div_pd(a, b)
+#define wide_sqrt(a) _mm512_sqrt_pd(a)
+#define wide_mul_add(a, b, c) _mm512_fmadd_pd(a, b, c)
+#define wide_as_u64(a) _mm512_castpd_si512(a)
+#define wide_as_f64(a) _mm512_castsi512_pd(a)
+#define wide_and(a, b) wide_as_f64(_mm512_and_si512(wide_as_u64(a), wide_as_u64(b)))
+#define wide_or(a, b) wide_as_f64(_mm512_or_si512(wide_as_u64(a), wide_as_u64(b)))
+#define wide_xor(a, b) wide_as_f64(_mm512_xor_si512(wide_as_u64(a), wide_as_u64(b)))
+#define wide_andnot(a, b) wide_as_f64(_mm512_andnot_si512(wide_as_u64(a), wide_as_u64(b)))
+#define wide_cmp_lt(a, b) \
+    wide_as_f64(_mm512_maskz_mov_epi64(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ), _mm512_set1_epi64(-1)))
+#define wide_select(mask, a, b) \
+    _mm512_mask_blend_pd(_mm512_test_epi64_mask(wide_as_u64(mask), wide_as_u64(mask)), b, a)
+#define wide_reduce_add(a) _mm512_reduce_add_pd(a)
+#define wide_add_u64(a, b) _mm512_add_epi64(a, b)
+#define wide_sub_u64(a, b) _mm512_sub_epi64(a, b)
+#define wide_and_u64(a, b) _mm512_and_si512(a, b)
+#define wide_shl_u64(a, count) _mm512_slli_epi64(a, count)
+#define wide_shr_u64(a, count) _mm512_srli_epi64(a, count)
+#define wide_xor_u64(a, b) _mm512_xor_si512(a, b)
+#define wide_or_u64(a, b) _mm512_or_si512(a, b)
+#define wide_load_u64(ptr) _mm512_loadu_si512(ptr)
+#define wide_store_u64(ptr, a) _mm512_storeu_si512(ptr, a)
+#define wide_mul_u32_u64(a, b) _mm512_mul_epu32(a, b)
+
+#endif
+
+/* NOTE(abid): `wide_fn(sin)` becomes `sin_avx2` and so on. */
+#undef wide_fn
+#define wide_fn(name) __wide_fn_expand(name, wide_suffix)
+
+#endif
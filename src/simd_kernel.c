@@ -0,0 +1,239 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 10:48:03 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+/* NOTE(abid): Templated on the `wide_*` vocabulary of simd.h, included once per ISA from
+ * kernel.c, so no include guard. Needs simd_math.c of the same ISA to be included before. */
+
+/* NOTE(abid): Tails are run through one more full-width pass with zero-padded lanes, these move
+ * them in and out of a full register. */
+wide_target internal inline wide_f64
+wide_fn(simd_load_tail)(f64 *src, u64 count) {
+    f64 lanes[SIMD_WIDTH] = {0};
+    for(u64 lane = 0; lane < count; ++lane) lanes[lane] = src[lane];
+    return wide_load(lanes);
+}
+
+wide_target internal inline void
+wide_fn(simd_store_tail)(f64 *dest, wide_f64 value, u64 count) {
+    f64 lanes[SIMD_WIDTH];
+    wide_store(lanes, value);
+    for(u64 lane = 0; lane < count; ++lane) dest[lane] = lanes[lane];
+}
+
+wide_target internal inline wide_f64
+wide_fn(simd_haversine)(wide_f64 x0, wide_f64 y0, wide_f64 x1, wide_f64 y1, wide_f64 earth_radius,
+                       math_tier tier) {
+    /* NOTE(abid): Same order of operations as `haversine()`, including its f32 degree->radian
+     * constant, so the results line up with the .f64 reference. */
+    wide_f64 to_radians = wide_set1(radians_from_degrees(1.0));
+    wide_f64 half = wide_set1(0.5);
+
+    wide_f64 dlat = wide_mul(wide_sub(y1, y0), to_radians);
+    wide_f64 dlon = wide_mul(wide_sub(x1, x0), to_radians);
+    wide_f64 lat1 = wide_mul(y0, to_radians);
+    wide_f64 lat2 = wide_mul(y1, to_radians);
+
+    wide_f64 sin_dlat = wide_fn(simd_sin)(wide_mul(dlat, half), tier);
+    wide_f64 sin_dlon = wide_fn(simd_sin)(wide_mul(dlon, half), tier);
+    wide_f64 cos_lats = wide_mul(wide_fn(simd_cos)(lat1, tier), wide_fn(simd_cos)(lat2, tier));
+
+    wide_f64 a = wide_add(wide_mul(sin_dlat, sin_dlat), wide_mul(cos_lats, wide_mul(sin_dlon, sin_dlon)));
+    wide_f64 c = wide_mul(wide_set1(2.0), wide_fn(simd_asin)(wide_sqrt(a), tier));
+
+    return wide_mul(earth_radius, c);
+}
+
+/* NOTE(abid): A zero pair has a distance of exactly zero, so the padded tail lanes do not disturb
+ * the sum. */
+wide_target internal void
+wide_fn(haversine_batch)(pair_soa *pairs, f64 *distances, f64 earth_radius, math_tier tier) {
+    wide_f64 radius = wide_set1(earth_radius);
+
+    u64 idx = 0;
+    for(; idx + SIMD_WIDTH <= pairs->count; idx += SIMD_WIDTH) {
+        wide_f64 d = wide_fn(simd_haversine)(wide_load(pairs->x0 + idx), wide_load(pairs->y0 + idx),
+                                             wide_load(pairs->x1 + idx), wide_load(pairs->y1 + idx), radius, tier);
+        wide_store(distances + idx, d);
+    }
+
+    if(idx < pairs->count) {
+        u64 tail_count = pairs->count - idx;
+        wide_f64 d = wide_fn(simd_haversine)(wide_fn(simd_load_tail)(pairs->x0 + idx, tail_count),
+                                             wide_fn(simd_load_tail)(pairs->y0 + idx, tail_count),
+                                             wide_fn(simd_load_tail)(pairs->x1 + idx, tail_count),
+                                             wide_fn(simd_load_tail)(pairs->y1 + idx, tail_count), radius, tier);
+        wide_fn(simd_store_tail)(distances + idx, d, tail_count);
+    }
+}
+
+wide_target internal f64
+wide_fn(haversine_batch_sum)(pair_soa *pairs, f64 earth_radius, math_tier tier) {
+    wide_f64 radius = wide_set1(earth_radius);
+    wide_f64 sum = wide_zero();
+
+    u64 idx = 0;
+    for(; idx + SIMD_WIDTH <= pairs->count; idx += SIMD_WIDTH) {
+        wide_f64 d = wide_fn(simd_haversine)(wide_load(pairs->x0 + idx), wide_load(pairs->y0 + idx),
+                                             wide_load(pairs->x1 + idx), wide_load(pairs->y1 + idx), radius, tier);
+        sum = wide_add(sum, d);
+    }
+
+    if(idx < pairs->count) {
+        u64 tail_count = pairs->count - idx;
+        wide_f64 d = wide_fn(simd_haversine)(wide_fn(simd_load_tail)(pairs->x0 + idx, tail_count),
+                                             wide_fn(simd_load_tail)(pairs->y0 + idx, tail_count),
+                                             wide_fn(simd_load_tail)(pairs->x1 + idx, tail_count),
+                                             wide_fn(simd_load_tail)(pairs->y1 + idx, tail_count), radius, tier);
+        sum = wide_add(sum, d);
+    }
+
+    return wide_reduce_add(sum);
+}
+
+/* NOTE(abid): `count` quantized coordinates from `src` as degrees, zero-padded past `count`. */
+wide_target internal inline wide_f64
+wide_fn(simd_load_q32)(i32 *src, u64 count) {
+    wide_f64 to_degrees = wide_set1(1.0 / PAIR_Q32_SCALE);
+    if(count == SIMD_WIDTH) return wide_mul(wide_load_i32(src), to_degrees);
+
+    i32 lanes[SIMD_WIDTH] = {0};
+    for(u64 lane = 0; lane < count; ++lane) lanes[lane] = src[lane];
+    return wide_mul(wide_load_i32(lanes), to_degrees);
+}
+
+/* NOTE(abid): Distances of the `count` (at most SIMD_WIDTH) pairs at `idx`, decoded in registers
+ * on the way in so the doubles are never stored. */
+wide_target internal inline wide_f64
+wide_fn(simd_haversine_q32)(pair_soa_q32 *pairs, u64 idx, u64 count, wide_f64 earth_radius, math_tier tier) {
+    return wide_fn(simd_haversine)(wide_fn(simd_load_q32)(pairs->x0 + idx, count),
+                                   wide_fn(simd_load_q32)(pairs->y0 + idx, count),
+                                   wide_fn(simd_load_q32)(pairs->x1 + idx, count),
+                                   wide_fn(simd_load_q32)(pairs->y1 + idx, count), earth_radius, tier);
+}
+
+wide_target internal void
+wide_fn(haversine_batch_q32)(pair_soa_q32 *pairs, f64 *distances, f64 earth_radius, math_tier tier) {
+    wide_f64 radius = wide_set1(earth_radius);
+    for(u64 idx = 0; idx < pairs->count; idx += SIMD_WIDTH) {
+        u64 count = (pairs->count - idx < SIMD_WIDTH) ? pairs->count - idx : SIMD_WIDTH;
+        wide_f64 d = wide_fn(simd_haversine_q32)(pairs, idx, count, radius, tier);
+        if(count == SIMD_WIDTH) wide_store(distances + idx, d);
+        else wide_fn(simd_store_tail)(distances + idx, d, count);
+    }
+}
+
+wide_target internal f64
+wide_fn(haversine_batch_sum_q32)(pair_soa_q32 *pairs, f64 earth_radius, math_tier tier) {
+    wide_f64 radius = wide_set1(earth_radius);
+    wide_f64 sum = wide_zero();
+    for(u64 idx = 0; idx < pairs->count; idx += SIMD_WIDTH) {
+        u64 count = (pairs->count - idx < SIMD_WIDTH) ? pairs->count - idx : SIMD_WIDTH;
+        sum = wide_add(sum, wide_fn(simd_haversine_q32)(pairs, idx, count, radius, tier));
+    }
+
+    return wide_reduce_add(sum);
+}
+
+/* NOTE(abid): Unit vectors (earth-centered, earth-fixed, on the unit sphere) from degrees. The
+ * degree->radian constant is the one `haversine()` uses, so distances stay comparable. */
+wide_target internal void
+wide_fn(unit_vec_from_degrees)(f64 *lon, f64 *lat, unit_vec_soa *out, math_tier tier) {
+    wide_f64 to_radians = wide_set1(radians_from_degrees(1.0));
+    for(u64 idx = 0; idx < out->count; idx += SIMD_WIDTH) {
+        u64 count = (out->count - idx < SIMD_WIDTH) ? out->count - idx : SIMD_WIDTH;
+        wide_f64 lon_rad, lat_rad;
+        if(count == SIMD_WIDTH) {
+            lon_rad = wide_mul(wide_load(lon + idx), to_radians);
+            lat_rad = wide_mul(wide_load(lat + idx), to_radians);
+        } else {
+            lon_rad = wide_mul(wide_fn(simd_load_tail)(lon + idx, count), to_radians);
+            lat_rad = wide_mul(wide_fn(simd_load_tail)(lat + idx, count), to_radians);
+        }
+
+        wide_f64 cos_lat = wide_fn(simd_cos)(lat_rad, tier);
+        wide_f64 x = wide_mul(cos_lat, wide_fn(simd_cos)(lon_rad, tier));
+        wide_f64 y = wide_mul(cos_lat, wide_fn(simd_sin)(lon_rad, tier));
+        wide_f64 z = wide_fn(simd_sin)(lat_rad, tier);
+        if(count == SIMD_WIDTH) {
+            wide_store(out->x + idx, x);
+            wide_store(out->y + idx, y);
+            wide_store(out->z + idx, z);
+        } else {
+            wide_fn(simd_store_tail)(out->x + idx, x, count);
+            wide_fn(simd_store_tail)(out->y + idx, y, count);
+            wide_fn(simd_store_tail)(out->z + idx, z, count);
+        }
+    }
+}
+
+/* NOTE(abid): Great-circle distance from the chord c = |a - b| as 2R*asin(c/2), or only R*c when
+ * `is_chord_only`, which orders the same way and needs no trig at all. */
+wide_target internal inline wide_f64
+wide_fn(simd_chord_distance)(wide_f64 dx, wide_f64 dy, wide_f64 dz, wide_f64 earth_radius,
+                             bool is_chord_only, math_tier tier) {
+    wide_f64 chord = wide_sqrt(wide_add(wide_add(wide_mul(dx, dx), wide_mul(dy, dy)), wide_mul(dz, dz)));
+    wide_f64 result;
+    if(is_chord_only) result = wide_mul(earth_radius, chord);
+    else {
+        wide_f64 angle = wide_fn(simd_asin)(wide_mul(chord, wide_set1(0.5)), tier);
+        result = wide_mul(wide_mul(wide_set1(2.0), earth_radius), angle);
+    }
+
+    return result;
+}
+
+/* NOTE(abid): Distance between a[i] and b[i]. */
+wide_target internal void
+wide_fn(chord_batch)(unit_vec_soa *a, unit_vec_soa *b, f64 *distances, f64 earth_radius,
+                     bool is_chord_only, math_tier tier) {
+    wide_f64 radius = wide_set1(earth_radius);
+    for(u64 idx = 0; idx < a->count; idx += SIMD_WIDTH) {
+        u64 count = (a->count - idx < SIMD_WIDTH) ? a->count - idx : SIMD_WIDTH;
+        wide_f64 dx, dy, dz;
+        if(count == SIMD_WIDTH) {
+            dx = wide_sub(wide_load(a->x + idx), wide_load(b->x + idx));
+            dy = wide_sub(wide_load(a->y + idx), wide_load(b->y + idx));
+            dz = wide_sub(wide_load(a->z + idx), wide_load(b->z + idx));
+        } else {
+            dx = wide_sub(wide_fn(simd_load_tail)(a->x + idx, count), wide_fn(simd_load_tail)(b->x + idx, count));
+            dy = wide_sub(wide_fn(simd_load_tail)(a->y + idx, count), wide_fn(simd_load_tail)(b->y + idx, count));
+            dz = wide_sub(wide_fn(simd_load_tail)(a->z + idx, count), wide_fn(simd_load_tail)(b->z + idx, count));
+        }
+
+        wide_f64 d = wide_fn(simd_chord_distance)(dx, dy, dz, radius, is_chord_only, tier);
+        if(count == SIMD_WIDTH) wide_store(distances + idx, d);
+        else wide_fn(simd_store_tail)(distances + idx, d, count);
+    }
+}
+
+/* NOTE(abid): Distance between every point and one query point. */
+wide_target internal void
+wide_fn(chord_to_point_batch)(unit_vec_soa *points, f64 query_x, f64 query_y, f64 query_z, f64 *distances,
+                              f64 earth_radius, bool is_chord_only, math_tier tier) {
+    wide_f64 radius = wide_set1(earth_radius);
+    wide_f64 qx = wide_set1(query_x);
+    wide_f64 qy = wide_set1(query_y);
+    wide_f64 qz = wide_set1(query_z);
+    for(u64 idx = 0; idx < points->count; idx += SIMD_WIDTH) {
+        u64 count = (points->count - idx < SIMD_WIDTH) ? points->count - idx : SIMD_WIDTH;
+        wide_f64 dx, dy, dz;
+        if(count == SIMD_WIDTH) {
+            dx = wide_sub(wide_load(points->x + idx), qx);
+            dy = wide_sub(wide_load(points->y + idx), qy);
+            dz = wide_sub(wide_load(points->z + idx), qz);
+        } else {
+            dx = wide_sub(wide_fn(simd_load_tail)(points->x + idx, count), qx);
+            dy = wide_sub(wide_fn(simd_load_tail)(points->y + idx, count), qy);
+            dz = wide_sub(wide_fn(simd_load_tail)(points->z + idx, count), qz);
+        }
+
+        wide_f64 d = wide_fn(simd_chord_distance)(dx, dy, dz, radius, is_chord_only, tier);
+        if(count == SIMD_WIDTH) wide_store(distances + idx, d);
+        else wide_fn(simd_store_tail)(distances + idx, d, count);
+    }
+}
@@ -0,0 +1,176 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 10:21:47 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+/* NOTE(abid): Templated on the `wide_*` vocabulary of simd.h, so this file is included once per
+ * ISA (see kernel.c) and has no include guard on purpose.
+ *
+ * math_tier_precise uses the fdlibm kernels (k_sin.c, k_cos.c, e_asin.c), which are < 1 ULP on
+ * their reduced ranges. math_tier_fast uses shorter minimax fits on the same ranges (and no
+ * division in asin), at ~1e-12..1e-10 error. Range reduction for sin/cos is
+ * Cody-Waite by pi/2 with a three-part constant and is shared by both tiers, it is good for
+ * |x| < ~1e5 which is plenty for anything in degrees. - 18.Oct.2026 */
+
+wide_target internal inline wide_f64
+wide_fn(simd_sin_poly)(wide_f64 x) {
+    /* NOTE(abid): sin(x) on [-pi/4, pi/4]. */
+    wide_f64 z = wide_mul(x, x);
+    wide_f64 r = wide_mul_add(z, wide_set1( 1.58969099521155010221e-10), wide_set1(-2.50507602534068634195e-08));
+    r = wide_mul_add(z, r, wide_set1( 2.75573137070700676789e-06));
+    r = wide_mul_add(z, r, wide_set1(-1.98412698298579493134e-04));
+    r = wide_mul_add(z, r, wide_set1( 8.33333333332248946124e-03));
+    r = wide_mul_add(z, r, wide_set1(-1.66666666666666324348e-01));
+
+    return wide_mul_add(wide_mul(z, x), r, x);
+}
+
+wide_target internal inline wide_f64
+wide_fn(simd_sin_poly_fast)(wide_f64 x) {
+    /* NOTE(abid): sin(x) on [-pi/4, pi/4], 4.9e-12 max relative error. */
+    wide_f64 z = wide_mul(x, x);
+    wide_f64 r = wide_mul_add(z, wide_set1( 2.71831166771746185e-06), wide_set1(-1.98393348540542127e-04));
+    r = wide_mul_add(z, r, wide_set1( 8.33332938594349808e-03));
+    r = wide_mul_add(z, r, wide_set1(-1.66666666416269482e-01));
+
+    return wide_mul_add(wide_mul(z, x), r, x);
+}
+
+wide_target internal inline wide_f64
+wide_fn(simd_cos_poly)(wide_f64 x) {
+    /* NOTE(abid): cos(x) on [-pi/4, pi/4]. `1 - z/2` is summed with its rounding error put back,
+     * same as fdlibm does, otherwise we lose a bit near the ends of the range. */
+    wide_f64 one = wide_set1(1.0);
+    wide_f64 z = wide_mul(x, x);
+    wide_f64 r = wide_mul_add(z, wide_set1(-1.13596475577881948265e-11), wide_set1( 2.08757232129817482790e-09));
+    r = wide_mul_add(z, r, wide_set1(-2.75573143513906633035e-07));
+    r = wide_mul_add(z, r, wide_set1( 2.48015872894767294178e-05));
+    r = wide_mul_add(z, r, wide_set1(-1.38888888888741095749e-03));
+    r = wide_mul_add(z, r, wide_set1( 4.16666666666666019037e-02));
+
+    wide_f64 half_z = wide_mul(z, wide_set1(0.5));
+    wide_f64 w = wide_sub(one, half_z);
+    wide_f64 w_err = wide_sub(wide_sub(one, w), half_z);
+
+    return wide_add(w, wide_mul_add(wide_mul(z, z), r, w_err));
+}
+
+wide_target internal inline wide_f64
+wide_fn(simd_cos_poly_fast)(wide_f64 x) {
+    /* NOTE(abid): cos(x) on [-pi/4, pi/4], 2.9e-13 max absolute error. */
+    wide_f64 z = wide_mul(x, x);
+    wide_f64 r = wide_mul_add(z, wide_set1(-2.72371806731733747e-07), wide_set1( 2.47999118568528980e-05));
+    r = wide_mul_add(z, r, wide_set1(-1.38888855483157978e-03));
+    r = wide_mul_add(z, r, wide_set1( 4.16666666479458617e-02));
+
+    return wide_mul_add(wide_mul(z, z), r, wide_mul_add(z, wide_set1(-0.5), wide_set1(1.0)));
+}
+
+/* NOTE(abid): Reduces x to r in [-pi/4, pi/4] with x = r + n*pi/2, the quadrant n is returned in
+ * the low bits of `quadrant` (only the low two bits are meaningful). */
+wide_target internal inline wide_f64
+wide_fn(simd_reduce_pio2)(wide_f64 x, wide_u64 *quadrant) {
+    /* NOTE(abid): Adding 1.5*2^52 rounds to integer and leaves the integer in the low mantissa bits. */
+    wide_f64 magic = wide_set1(6755399441055744.0);
+    wide_f64 t = wide_mul_add(x, wide_set1(6.36619772367581382433e-01), magic);
+    wide_f64 n = wide_sub(t, magic);
+    *quadrant = wide_as_u64(t);
+
+    /* NOTE(abid): pi/2 split in three 33-bit parts, so `n*part` is exact for any n we care about. */
+    wide_f64 r = wide_sub(x, wide_mul(n, wide_set1(1.57079632673412561417e+00)));
+    r = wide_sub(r, wide_mul(n, wide_set1(6.07710050630396597660e-11)));
+    r = wide_sub(r, wide_mul(n, wide_set1(2.02226624871116645580e-21)));
+
+    return r;
+}
+
+wide_target internal inline wide_f64
+wide_fn(simd_sin)(wide_f64 x, math_tier tier) {
+    wide_u64 quadrant;
+    wide_f64 r = wide_fn(simd_reduce_pio2)(x, &quadrant);
+    wide_f64 sin_r, cos_r;
+    if(tier == math_tier_fast) {
+        sin_r = wide_fn(simd_sin_poly_fast)(r);
+        cos_r = wide_fn(simd_cos_poly_fast)(r);
+    } else {
+        sin_r = wide_fn(simd_sin_poly)(r);
+        cos_r = wide_fn(simd_cos_poly)(r);
+    }
+
+    /* NOTE(abid): Odd quadrants swap to cos, quadrants 2 and 3 flip the sign. */
+    wide_u64 one = wide_set1_u64(1);
+    wide_f64 swap = wide_as_f64(wide_sub_u64(wide_set1_u64(0), wide_and_u64(quadrant, one)));
+    wide_f64 sign = wide_as_f64(wide_shl_u64(wide_and_u64(quadrant, wide_set1_u64(2)), 62));
+
+    return wide_xor(wide_select(swap, cos_r, sin_r), sign);
+}
+
+wide_target internal inline wide_f64
+wide_fn(simd_cos)(wide_f64 x, math_tier tier) {
+    wide_u64 quadrant;
+    wide_f64 r = wide_fn(simd_reduce_pio2)(x, &quadrant);
+    wide_f64 sin_r, cos_r;
+    if(tier == math_tier_fast) {
+        sin_r = wide_fn(simd_sin_poly_fast)(r);
+        cos_r = wide_fn(simd_cos_poly_fast)(r);
+    } else {
+        sin_r = wide_fn(simd_sin_poly)(r);
+        cos_r = wide_fn(simd_cos_poly)(r);
+    }
+
+    /* NOTE(abid): Odd quadrants swap to sin, quadrants 1 and 2 flip the sign. */
+    wide_u64 one = wide_set1_u64(1);
+    wide_f64 swap = wide_as_f64(wide_sub_u64(wide_set1_u64(0), wide_and_u64(quadrant, one)));
+    wide_u64 quadrant_next = wide_add_u64(quadrant, one);
+    wide_f64 sign = wide_as_f64(wide_shl_u64(wide_and_u64(quadrant_next, wide_set1_u64(2)), 62));
+
+    return wide_xor(wide_select(swap, sin_r, cos_r), sign);
+}
+
+wide_target internal inline wide_f64
+wide_fn(simd_asin)(wide_f64 x, math_tier tier) {
+    /* NOTE(abid): For |x| < 0.5, asin(x) = x + x*R(x^2). Otherwise we use
+     * asin(x) = pi/2 - 2*asin(sqrt((1-|x|)/2)), with the same R. Both sides are computed and the
+     * lanes pick, which is cheaper than branching on mixed lanes. */
+    wide_f64 one = wide_set1(1.0);
+    wide_f64 sign_mask = wide_set1(-0.0);
+    wide_f64 sign = wide_and(x, sign_mask);
+    wide_f64 abs_x = wide_andnot(sign_mask, x);
+
+    wide_f64 is_small = wide_cmp_lt(abs_x, wide_set1(0.5));
+    wide_f64 z = wide_select(is_small, wide_mul(abs_x, abs_x),
+                             wide_mul(wide_sub(one, abs_x), wide_set1(0.5)));
+    wide_f64 s = wide_select(is_small, abs_x, wide_sqrt(z));
+
+    wide_f64 r;
+    if(tier == math_tier_fast) {
+        /* NOTE(abid): R(z) as a plain polynomial on [0, 0.25], 2.8e-10 max relative error. */
+        r = wide_mul_add(z, wide_set1( 3.75652213002378860e-02), wide_set1( 1.44025920993740217e-02));
+        r = wide_mul_add(z, r, wide_set1( 3.18176150690739068e-02));
+        r = wide_mul_add(z, r, wide_set1( 4.45157198753030822e-02));
+        r = wide_mul_add(z, r, wide_set1( 7.50051091951126209e-02));
+        r = wide_mul_add(z, r, wide_set1( 1.66666598718675951e-01));
+        r = wide_mul(z, r);
+    } else {
+        wide_f64 p = wide_mul_add(z, wide_set1( 3.47933107596021167570e-05), wide_set1( 7.91534994289814532176e-04));
+        p = wide_mul_add(z, p, wide_set1(-4.00555345006794114027e-02));
+        p = wide_mul_add(z, p, wide_set1( 2.01212532134862925881e-01));
+        p = wide_mul_add(z, p, wide_set1(-3.25565818622400915405e-01));
+        p = wide_mul_add(z, p, wide_set1( 1.66666666666666657415e-01));
+        p = wide_mul(z, p);
+        wide_f64 q = wide_mul_add(z, wide_set1( 7.70381505559019352791e-02), wide_set1(-6.88283971605453293030e-01));
+        q = wide_mul_add(z, q, wide_set1( 2.02094576023350569471e+00));
+        q = wide_mul_add(z, q, wide_set1(-2.40339491173441421878e+00));
+        q = wide_mul_add(z, q, one);
+        r = wide_div(p, q);
+    }
+
+    wide_f64 asin_s = wide_mul_add(s, r, s);
+    wide_f64 large = wide_sub(wide_set1(1.57079632679489655800e+00),
+                              wide_sub(wide_add(asin_s, asin_s), wide_set1(6.12323399573676603587e-17)));
+
+    return wide_xor(wide_select(is_small, asin_s, large), sign);
+}
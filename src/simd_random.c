@@ -0,0 +1,47 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 18:02:37 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+/* NOTE(abid): Templated on the `wide_*` vocabulary of simd.h, included once per ISA from
+ * kernel.c, so no include guard. */
+
+/* NOTE(abid): Low 64 bits of a*b out of 32x32->64 multiplies, SSE2/AVX2 have no 64-bit one. */
+wide_target internal inline wide_u64
+wide_fn(simd_mul_u64)(wide_u64 a, wide_u64 b) {
+    wide_u64 cross = wide_add_u64(wide_mul_u32_u64(wide_shr_u64(a, 32), b),
+                                  wide_mul_u32_u64(a, wide_shr_u64(b, 32)));
+    return wide_add_u64(wide_mul_u32_u64(a, b), wide_shl_u64(cross, 32));
+}
+
+/* NOTE(abid): `round_count` rounds of RAND_LANE_COUNT values in [0, 1) into `dest`. The steps are
+ * `rand_stream_u64`'s, the top 52 bits of the result go into the mantissa of a number in [1, 2) and
+ * the 1 is taken off, all of it exact, so every ISA gives the same bits. */
+wide_target internal void
+wide_fn(rand_lanes_fill_unit)(rand_lanes *lanes, f64 *dest, u64 round_count) {
+    enum { register_count = RAND_LANE_COUNT / SIMD_WIDTH };
+    wide_u64 states[register_count];
+    for(u32 reg = 0; reg < register_count; ++reg) states[reg] = wide_load_u64(lanes->states + reg*SIMD_WIDTH);
+
+    wide_u64 multiplier = wide_set1_u64(2685821657736338717ULL);
+    wide_u64 one_bits = wide_set1_u64(0x3ff0000000000000ULL);
+    wide_f64 one = wide_set1(1.0);
+    for(u64 round = 0; round < round_count; ++round) {
+        for(u32 reg = 0; reg < register_count; ++reg) {
+            wide_u64 state = states[reg];
+            state = wide_xor_u64(state, wide_shr_u64(state, 21));
+            state = wide_xor_u64(state, wide_shl_u64(state, 35));
+            state = wide_xor_u64(state, wide_shr_u64(state, 4));
+            states[reg] = state;
+
+            wide_u64 value = wide_fn(simd_mul_u64)(state, multiplier);
+            wide_f64 unit = wide_sub(wide_as_f64(wide_or_u64(wide_shr_u64(value, 12), one_bits)), one);
+            wide_store(dest + round*RAND_LANE_COUNT + reg*SIMD_WIDTH, unit);
+        }
+    }
+
+    for(u32 reg = 0; reg < register_count; ++reg) wide_store_u64(lanes->states + reg*SIMD_WIDTH, states[reg]);
+}
@@ -0,0 +1,168 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 13:02:04 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#include "thread_pool.h"
+
+/* WARNING(abid): The profiler in bench.h is not thread safe, job functions must not use the
+ * bench_* macros. */
+
+internal void
+thread_deque_push(thread_deque *deque, thread_range range) {
+    spin_lock(&deque->lock);
+    assert(deque->bottom < deque->capacity, "thread deque is full.");
+    deque->ranges[deque->bottom++] = range;
+    spin_unlock(&deque->lock);
+}
+
+internal bool
+thread_deque_pop(thread_deque *deque, thread_range *range) {
+    bool result = false;
+    spin_lock(&deque->lock);
+    if(deque->top < deque->bottom) {
+        *range = deque->ranges[--deque->bottom];
+        result = true;
+    }
+    spin_unlock(&deque->lock);
+
+    return result;
+}
+
+internal bool
+thread_deque_steal(thread_deque *deque, thread_range *range) {
+    bool result = false;
+    spin_lock(&deque->lock);
+    if(deque->top < deque->bottom) {
+        *range = deque->ranges[deque->top++];
+        result = true;
+    }
+    spin_unlock(&deque->lock);
+
+    return result;
+}
+
+/* NOTE(abid): Runs chunks until every deque is empty. Jobs never push new chunks, so once we come
+ * back empty-handed from all the victims there is nothing left to do. */
+internal void
+thread_worker_run(thread_worker *worker) {
+    thread_pool *pool = worker->pool;
+
+    while(true) {
+        thread_range range;
+        if(!thread_deque_pop(&worker->deque, &range)) {
+            bool is_stolen = false;
+            for(u32 offset = 1; offset < pool->worker_count; ++offset) {
+                thread_worker *victim = pool->workers + (worker->idx + offset) % pool->worker_count;
+                if(thread_deque_steal(&victim->deque, &range)) {
+                    ++worker->stat.steal_count;
+                    is_stolen = true;
+                    break;
+                }
+            }
+            if(!is_stolen) break;
+        }
+
+        u64 os_start = platform_get_os_timer();
+        pool->job_fn(pool->job_data, range.first, range.count, worker->idx);
+        worker->stat.busy_time += platform_get_os_timer() - os_start;
+        ++worker->stat.chunk_count;
+    }
+}
+
+internal PLATFORM_THREAD_PROC(thread_worker_main) {
+    thread_worker *worker = (thread_worker *)param;
+    thread_pool *pool = worker->pool;
+
+    while(true) {
+        platform_semaphore_wait(&worker->wake);
+        if(interlocked_load_u32(&pool->is_shutting_down)) break;
+
+        thread_worker_run(worker);
+        interlocked_add_u32(&pool->workers_done, 1);
+    }
+
+    return 0;
+}
+
+/* NOTE(abid): `thread_count` of 0 means one per logical processor. */
+internal thread_pool *
+thread_pool_create(u32 thread_count) {
+    if(thread_count == 0) thread_count = platform_cpu_get_count();
+
+    mem_arena *arena = arena_create(megabyte(1), gigabyte(1));
+    thread_pool *pool = push_struct(thread_pool, arena);
+    pool->arena = arena;
+    pool->worker_count = thread_count;
+    pool->workers = push_array(thread_worker, thread_count, arena);
+
+    for(u32 idx = 0; idx < thread_count; ++idx) {
+        thread_worker *worker = pool->workers + idx;
+        worker->pool = pool;
+        worker->idx = idx;
+        if(idx == 0) continue;
+
+        platform_semaphore_init(&worker->wake);
+        worker->thread = platform_thread_create(thread_worker_main, worker);
+    }
+
+    return pool;
+}
+
+internal void
+thread_pool_destroy(thread_pool *pool) {
+    interlocked_exchange_u32(&pool->is_shutting_down, 1);
+    for(u32 idx = 1; idx < pool->worker_count; ++idx) {
+        thread_worker *worker = pool->workers + idx;
+        platform_semaphore_post(&worker->wake);
+        platform_thread_join(worker->thread);
+        platform_semaphore_destroy(&worker->wake);
+    }
+
+    arena_free(pool->arena);
+}
+
+/* NOTE(abid): Splits [0, count) into `chunk_size` chunks and runs `job_fn` on all of them across
+ * the pool, returns once every chunk is done. Chunks are dealt out to the workers as contiguous
+ * blocks, in order, and idle workers steal from the far end of someone else's block. */
+internal void
+thread_pool_parallel_for(thread_pool *pool, u64 count, u64 chunk_size, thread_job_fn *job_fn, void *job_data) {
+    assert(chunk_size > 0, "chunk size cannot be zero.");
+    if(count == 0) return;
+
+    temp_memory temp = mem_temp_begin(pool->arena);
+
+    u64 chunk_count = (count + chunk_size - 1) / chunk_size;
+    assert(chunk_count <= 0xFFFFFFFF, "too many chunks, use a bigger chunk size.");
+    for(u32 idx = 0; idx < pool->worker_count; ++idx) {
+        thread_worker *worker = pool->workers + idx;
+
+        u64 chunk_begin = chunk_count*idx / pool->worker_count;
+        u64 chunk_end = chunk_count*(idx + 1) / pool->worker_count;
+        worker->deque = (thread_deque) {
+            .capacity = (u32)(chunk_end - chunk_begin),
+            .ranges = push_array(thread_range, chunk_end - chunk_begin, pool->arena),
+        };
+        worker->stat = (thread_worker_stat){0};
+
+        /* NOTE(abid): Pushed in reverse, so the owner pops its block front to back. */
+        for(u64 chunk_idx = chunk_end; chunk_idx > chunk_begin; --chunk_idx) {
+            u64 first = (chunk_idx - 1)*chunk_size;
+            u64 range_count = (first + chunk_size > count) ? count - first : chunk_size;
+            thread_deque_push(&worker->deque, (thread_range){ .first = first, .count = range_count });
+        }
+    }
+
+    pool->job_fn = job_fn;
+    pool->job_data = job_data;
+    pool->workers_done = 0;
+    for(u32 idx = 1; idx < pool->worker_count; ++idx) platform_semaphore_post(&pool->workers[idx].wake);
+
+    thread_worker_run(pool->workers);
+    while(interlocked_load_u32(&pool->workers_done) != pool->worker_count - 1) platform_thread_yield();
+
+    mem_temp_end(temp);
+}
@@ -0,0 +1,64 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 13:02:31 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#if !defined(THREAD_POOL_H)
+
+/* NOTE(abid): Called once per chunk, with `first` and `count` in the caller's index space. A call
+ * is always exactly one chunk of `thread_pool_parallel_for`: `first` is a multiple of its
+ * `chunk_size` and `count` is `chunk_size`, less only for the last chunk. Jobs may index per-chunk
+ * results by `first / chunk_size`. */
+typedef void thread_job_fn(void *data, u64 first, u64 count, u32 worker_idx);
+
+typedef struct {
+    u64 first;
+    u64 count;
+} thread_range;
+
+/* NOTE(abid): The owner pops from `bottom`, thieves take from `top`. A spin lock is plenty here,
+ * chunks are big enough that the deque is touched a handful of times per millisecond. */
+typedef struct {
+    volatile u32 lock;
+    u32 top;
+    u32 bottom;
+    u32 capacity;
+    thread_range *ranges;
+} thread_deque;
+
+typedef struct {
+    u64 chunk_count; /* NOTE(abid): Chunks this worker ran, own and stolen. */
+    u64 steal_count;
+    u64 busy_time; /* NOTE(abid): OS timer ticks spent inside the job function. */
+} thread_worker_stat;
+
+typedef struct thread_pool thread_pool;
+typedef struct {
+    thread_pool *pool;
+    u32 idx;
+
+    platform_thread thread;
+    platform_semaphore wake;
+    thread_deque deque;
+    thread_worker_stat stat;
+} thread_worker;
+
+/* NOTE(abid): Worker 0 is the calling thread, it does its share of the work and then waits for the
+ * others, so a pool of N has N-1 OS threads. */
+struct thread_pool {
+    u32 worker_count;
+    thread_worker *workers;
+    mem_arena *arena;
+
+    /* NOTE(abid): The current job. */
+    thread_job_fn *job_fn;
+    void *job_data;
+    volatile u32 workers_done;
+    volatile u32 is_shutting_down;
+};
+
+#define THREAD_POOL_H
+#endif
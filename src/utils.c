@@ -10,12 +10,19 @@
 
 #ifdef PLT_WIN
 #include <windows.h>
+#include <intrin.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #elif PLT_LINUX
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
 #include <string.h>
+#include <cpuid.h>
+#include <sched.h>
+#include <immintrin.h>
 #endif
 
 /* NOTE(abid): Byte Macros */
@@ -65,7 +72,6 @@ platform_file_64bit_get_size(char *filename) {
     _stat64(filename, &file_stat);
 
 #elif PLT_LINUX
-    assert(0, "NotImplemented.");
     struct stat file_stat;
     stat(filename, &file_stat);
 #endif
@@ -92,7 +98,29 @@ platform_ram_get_size() {
     return mem_stat.ullTotalPhys;
 #elif PLT_LINUX
     long pages = sysconf(_SC_PHYS_PAGES);
-    return pages * platform_get_page_size();
+    return pages * platform_page_get_size();
+#endif
+}
+
+/* NOTE(abid): `regs` is filled as eax, ebx, ecx, edx. */
+inline internal void
+platform_cpuid(u32 leaf, u32 subleaf, u32 *regs) {
+#ifdef PLT_WIN
+    __cpuidex((int *)regs, leaf, subleaf);
+#elif PLT_LINUX
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/* NOTE(abid): Only valid to call when cpuid reports OSXSAVE. */
+inline internal u64
+platform_xgetbv(u32 index) {
+#ifdef PLT_WIN
+    return _xgetbv(index);
+#elif PLT_LINUX
+    u32 eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((u64)edx << 32) | eax;
 #endif
 }
 
@@ -171,6 +199,266 @@ platform_free(void *ptr, usize size) {
     return result;
 }
 
+/* NOTE(abid): Maps `filename` read-only, false if it could not be opened or mapped. Pages come
+ * straight from the page cache, there is no copy and nothing to allocate. */
+internal bool
+platform_file_map(char *filename, u32 flags, platform_file_mapping *mapping) {
+    *mapping = (platform_file_mapping){0};
+#ifdef PLT_WIN
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              (flags & file_map_sequential) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER file_size;
+    bool result = GetFileSizeEx(file, &file_size) != 0;
+    mapping->size = (usize)file_size.QuadPart;
+    if(result && mapping->size) {
+        /* NOTE(abid): The view keeps the file and the mapping object alive, both can be closed. */
+        HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(file_mapping) {
+            mapping->data = (char *)MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(file_mapping);
+        }
+        result = mapping->data != NULL;
+    }
+    CloseHandle(file);
+#elif PLT_LINUX
+    i32 file = open(filename, O_RDONLY);
+    if(file < 0) return false;
+
+    struct stat file_stat;
+    bool result = fstat(file, &file_stat) == 0;
+    mapping->size = (usize)file_stat.st_size;
+    if(result && mapping->size) {
+        i32 map_flags = MAP_PRIVATE | ((flags & file_map_populate) ? MAP_POPULATE : 0);
+        void *data = mmap(NULL, mapping->size, PROT_READ, map_flags, file, 0);
+        result = data != MAP_FAILED;
+        if(result) {
+            mapping->data = (char *)data;
+            if(flags & file_map_sequential) madvise(data, mapping->size, MADV_SEQUENTIAL);
+            /* NOTE(abid): Only taken for file pages when the kernel has read-only THP for files. */
+            if(flags & file_map_hugepage) madvise(data, mapping->size, MADV_HUGEPAGE);
+        }
+    }
+    close(file);
+#endif
+    if(!result) *mapping = (platform_file_mapping){0};
+
+    return result;
+}
+
+internal void
+platform_file_unmap(platform_file_mapping *mapping) {
+    if(mapping->data == NULL) return;
+#ifdef PLT_WIN
+    UnmapViewOfFile(mapping->data);
+#elif PLT_LINUX
+    munmap(mapping->data, mapping->size);
+#endif
+    *mapping = (platform_file_mapping){0};
+}
+
+/* NOTE(abid): Creates `filename` for writing, or truncates it if it is there. */
+internal bool
+platform_file_create(char *filename, platform_file *file) {
+#ifdef PLT_WIN
+    file->handle = CreateFileA(filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    return file->handle != INVALID_HANDLE_VALUE;
+#elif PLT_LINUX
+    file->handle = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return file->handle >= 0;
+#endif
+}
+
+/* NOTE(abid): All of `size` or false, partial writes are carried on with. */
+internal bool
+platform_file_write(platform_file *file, void *data, usize size) {
+    char *src = (char *)data;
+    while(size) {
+#ifdef PLT_WIN
+        DWORD to_write = (size > 0x40000000) ? 0x40000000 : (DWORD)size;
+        DWORD written = 0;
+        if(!WriteFile(file->handle, src, to_write, &written, NULL)) return false;
+#elif PLT_LINUX
+        ssize_t written = write(file->handle, src, size);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+            return false;
+        }
+#endif
+        src += written;
+        size -= (usize)written;
+    }
+
+    return true;
+}
+
+/* NOTE(abid): Reserves disk space for `size` bytes up front, so the file system can lay it out in one
+ * piece. The file may grow to `size` on the way (it does on Linux), truncate it to what was written
+ * at the end. Only a hint, false where it is not supported. */
+internal bool
+platform_file_preallocate(platform_file *file, u64 size) {
+#ifdef PLT_WIN
+    FILE_ALLOCATION_INFO info = { .AllocationSize.QuadPart = (LONGLONG)size };
+    return SetFileInformationByHandle(file->handle, FileAllocationInfo, &info, sizeof(info)) != 0;
+#elif PLT_LINUX
+    return posix_fallocate(file->handle, 0, (off_t)size) == 0;
+#endif
+}
+
+/* NOTE(abid): Drops anything past `size`, including space preallocated and never written. */
+internal bool
+platform_file_truncate(platform_file *file, u64 size) {
+#ifdef PLT_WIN
+    FILE_END_OF_FILE_INFO info = { .EndOfFile.QuadPart = (LONGLONG)size };
+    return SetFileInformationByHandle(file->handle, FileEndOfFileInfo, &info, sizeof(info)) != 0;
+#elif PLT_LINUX
+    return ftruncate(file->handle, (off_t)size) == 0;
+#endif
+}
+
+internal bool
+platform_file_close(platform_file *file) {
+#ifdef PLT_WIN
+    bool result = CloseHandle(file->handle) != 0;
+#elif PLT_LINUX
+    bool result = close(file->handle) == 0;
+#endif
+    *file = (platform_file){0};
+
+    return result;
+}
+
+/* NOTE(abid): Number of logical processors available to us. */
+inline internal u32
+platform_cpu_get_count() {
+#ifdef PLT_WIN
+    SYSTEM_INFO sys_info = {0};
+    GetSystemInfo(&sys_info);
+    return sys_info.dwNumberOfProcessors;
+#elif PLT_LINUX
+    return (u32)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+internal platform_thread
+platform_thread_create(platform_thread_proc *proc, void *param) {
+    platform_thread result = {0};
+#ifdef PLT_WIN
+    result.handle = CreateThread(NULL, 0, proc, param, 0, NULL);
+    assert(result.handle != NULL, "could not create thread.");
+#elif PLT_LINUX
+    i32 error = pthread_create(&result.handle, NULL, proc, param);
+    assert(error == 0, "could not create thread (%d).", error);
+#endif
+
+    return result;
+}
+
+inline internal void
+platform_thread_join(platform_thread thread) {
+#ifdef PLT_WIN
+    WaitForSingleObject(thread.handle, INFINITE);
+    CloseHandle(thread.handle);
+#elif PLT_LINUX
+    pthread_join(thread.handle, NULL);
+#endif
+}
+
+inline internal void
+platform_thread_yield() {
+#ifdef PLT_WIN
+    SwitchToThread();
+#elif PLT_LINUX
+    sched_yield();
+#endif
+}
+
+inline internal void
+platform_semaphore_init(platform_semaphore *semaphore) {
+#ifdef PLT_WIN
+    semaphore->handle = CreateSemaphoreA(NULL, 0, 0x7FFFFFFF, NULL);
+    assert(semaphore->handle != NULL, "could not create semaphore.");
+#elif PLT_LINUX
+    assert(sem_init(&semaphore->handle, 0, 0) == 0, "could not create semaphore.");
+#endif
+}
+
+inline internal void
+platform_semaphore_destroy(platform_semaphore *semaphore) {
+#ifdef PLT_WIN
+    CloseHandle(semaphore->handle);
+#elif PLT_LINUX
+    sem_destroy(&semaphore->handle);
+#endif
+}
+
+inline internal void
+platform_semaphore_post(platform_semaphore *semaphore) {
+#ifdef PLT_WIN
+    ReleaseSemaphore(semaphore->handle, 1, NULL);
+#elif PLT_LINUX
+    sem_post(&semaphore->handle);
+#endif
+}
+
+inline internal void
+platform_semaphore_wait(platform_semaphore *semaphore) {
+#ifdef PLT_WIN
+    WaitForSingleObject(semaphore->handle, INFINITE);
+#elif PLT_LINUX
+    while(sem_wait(&semaphore->handle) != 0) { /* NOTE(abid): Interrupted by a signal. */ }
+#endif
+}
+
+/* NOTE(abid): Interlocked routines, all of them are full barriers. They return the old value. */
+inline internal u64
+interlocked_add_u64(volatile u64 *dest, u64 value) {
+#ifdef PLT_WIN
+    return (u64)InterlockedExchangeAdd64((volatile LONG64 *)dest, (LONG64)value);
+#elif PLT_LINUX
+    return __atomic_fetch_add(dest, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline internal u32
+interlocked_add_u32(volatile u32 *dest, u32 value) {
+#ifdef PLT_WIN
+    return (u32)InterlockedExchangeAdd((volatile LONG *)dest, (LONG)value);
+#elif PLT_LINUX
+    return __atomic_fetch_add(dest, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline internal u32
+interlocked_exchange_u32(volatile u32 *dest, u32 value) {
+#ifdef PLT_WIN
+    return (u32)InterlockedExchange((volatile LONG *)dest, (LONG)value);
+#elif PLT_LINUX
+    return __atomic_exchange_n(dest, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline internal u32
+interlocked_load_u32(volatile u32 *src) {
+#ifdef PLT_WIN
+    return (u32)InterlockedCompareExchange((volatile LONG *)src, 0, 0);
+#elif PLT_LINUX
+    return __atomic_load_n(src, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* NOTE(abid): Tiny spin lock, only meant for very short critical sections. */
+inline internal void
+spin_lock(volatile u32 *lock) {
+    while(interlocked_exchange_u32(lock, 1)) {
+        while(interlocked_load_u32(lock)) _mm_pause();
+    }
+}
+
+inline internal void
+spin_unlock(volatile u32 *lock) { interlocked_exchange_u32(lock, 0); }
+
 inline internal temp_memory
 mem_temp_begin(mem_arena *arena) {
     temp_memory result = {0};
@@ -257,6 +545,18 @@ push_size(usize size, mem_arena *arena) {
     return result;
 }
 
+/* NOTE(abid): `alignment` must be a power of two. */
+#define push_array_aligned(type, count, alignment, arena) \
+    (type *)push_size_aligned((count)*sizeof(type), alignment, arena)
+internal void *
+push_size_aligned(usize size, usize alignment, mem_arena *arena) {
+    usize misalignment = ((usize)arena->ptr + arena->used) & (alignment - 1);
+    usize padding = misalignment ? alignment - misalignment : 0;
+    u8 *result = (u8 *)push_size(padding + size, arena) + padding;
+
+    return result;
+}
+
 #define arena_current(Arena) (void *)((u8 *)(Arena)->ptr + (Arena)->used)
 #define arena_advance(Arena, Number, Type) (Arena)->used += sizeof(Type)*(Number)
 
@@ -268,16 +568,127 @@ cstring_length(char *c_string) {
     return result;
 }
 
-internal u64
-hash_from_string(char *string) {
-    /* NOTE(abid): Adapted from `https://stackoverflow.com/questions/7616461/generate-a-hash-from-string-in-javascript` */
-    usize string_len = cstring_length(string);
-    usize hash = 0;
-    if(string_len == 0) return hash;
+/* NOTE(abid): `value` must not be zero. */
+inline internal u32
+count_leading_zeros_u64(u64 value) {
+#ifdef PLT_WIN
+    unsigned long idx;
+    _BitScanReverse64(&idx, value);
+    return 63 - (u32)idx;
+#elif PLT_LINUX
+    return (u32)__builtin_clzll(value);
+#endif
+}
+
+/* NOTE(abid): `value` must not be zero. */
+inline internal u32
+count_trailing_zeros_u64(u64 value) {
+#ifdef PLT_WIN
+    unsigned long idx;
+    _BitScanForward64(&idx, value);
+    return (u32)idx;
+#elif PLT_LINUX
+    return (u32)__builtin_ctzll(value);
+#endif
+}
+
+/* NOTE(abid): Full 64x64 -> 128 bit multiply, the high half goes to `high`. */
+inline internal u64
+multiply_u64_full(u64 a, u64 b, u64 *high) {
+#ifdef PLT_WIN
+    return _umul128(a, b, high);
+#elif PLT_LINUX
+    unsigned __int128 result = (unsigned __int128)a * b;
+    *high = (u64)(result >> 64);
+    return (u64)result;
+#endif
+}
+
+/* NOTE(abid): Longest `format_f64_fixed` output besides the `precision` digits: sign, the 309 integer
+ * digits of the largest double and the point. */
+#define FORMAT_F64_FIXED_MAX_PREFIX 311
+
+/* NOTE(abid): `value` with `precision` digits after the point, the same bytes as printf's "%.*f" (the
+ * exact binary value rounded half to even) without the terminator, returns the length. Fast when the
+ * fraction fits in 64 bits, 2^-12 <= |value| < 2^63 and zero, digits come out of it one multiply by
+ * 100 at a time. Anything else goes to snprintf, `dest` needs room for
+ * FORMAT_F64_FIXED_MAX_PREFIX + `precision` bytes plus a terminator for it. */
+internal usize
+format_f64_fixed(char *dest, f64 value, u32 precision) {
+    f64 magnitude = fabs(value);
+    if(!((magnitude >= 1.0/4096.0 && magnitude < 9223372036854775808.0) || magnitude == 0.0)) {
+        return (usize)snprintf(dest, FORMAT_F64_FIXED_MAX_PREFIX + precision + 1, "%.*f", precision, value);
+    }
+
+    /* NOTE(abid): Both parts exact, the fraction as a 0.64 fixed-point number. */
+    u64 integer = (u64)magnitude;
+    u64 fraction = (u64)((magnitude - (f64)integer) * 18446744073709551616.0);
+
+    char *out = dest;
+    if(signbit(value)) *out++ = '-';
+    char integer_digits[20];
+    u32 integer_count = 0;
+    char *digits = out;
+
+    /* NOTE(abid): Integer digits are written after the fraction is rounded, it may carry into them. */
+    char fraction_digits[64];
+    char *fraction_out = (precision <= sizeof(fraction_digits)) ? fraction_digits : malloc(precision);
+    u32 idx = 0;
+    for(; idx + 2 <= precision; idx += 2) {
+        u64 digits_pair;
+        fraction = multiply_u64_full(fraction, 100, &digits_pair);
+        fraction_out[idx] = (char)('0' + digits_pair / 10);
+        fraction_out[idx + 1] = (char)('0' + digits_pair % 10);
+    }
+    if(idx < precision) {
+        u64 digit;
+        fraction = multiply_u64_full(fraction, 10, &digit);
+        fraction_out[idx] = (char)('0' + digit);
+    }
 
+    u64 half = 1ULL << 63;
+    bool is_odd = precision ? ((fraction_out[precision-1] - '0') & 1) : (integer & 1);
+    if(fraction > half || (fraction == half && is_odd)) {
+        i64 idx = (i64)precision - 1;
+        for(; idx >= 0 && fraction_out[idx] == '9'; --idx) fraction_out[idx] = '0';
+        if(idx >= 0) ++fraction_out[idx];
+        else ++integer;
+    }
+
+    do {
+        integer_digits[integer_count++] = (char)('0' + integer % 10);
+        integer /= 10;
+    } while(integer);
+    while(integer_count) *digits++ = integer_digits[--integer_count];
+
+    if(precision) {
+        *digits++ = '.';
+        memcpy(digits, fraction_out, precision);
+        digits += precision;
+    }
+    if(fraction_out != fraction_digits) free(fraction_out);
+
+    return (usize)(digits - dest);
+}
+
+/* NOTE(abid): FNV-1a, then the finalizer of MurmurHash3 so that every input bit reaches every
+ * output bit. Without it short keys like "x0"/"y0" differ only in the low bits, which is all a
+ * power-of-two table looks at. */
+internal u64
+hash_from_bytes(char *string, usize string_len) {
+    u64 hash = 0xcbf29ce484222325ULL;
     for(usize idx = 0; idx < string_len; ++idx) {
-        char chr = string[idx];
-        hash = ((hash << 5) - hash) + chr;
+        hash ^= (u8)string[idx];
+        hash *= 0x100000001b3ULL;
     }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
     return hash;
 }
+
+inline internal u64
+hash_from_string(char *string) { return hash_from_bytes(string, cstring_length(string)); }
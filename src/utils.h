@@ -8,6 +8,13 @@
 
 #if !defined(UTILS_H)
 
+#ifdef PLT_WIN
+#include <windows.h>
+#elif PLT_LINUX
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
 typedef struct mem_arena mem_arena;
 struct mem_arena {
     usize used;
@@ -24,5 +31,51 @@ typedef struct {
     usize used;
 } temp_memory;
 
+typedef struct {
+#ifdef PLT_WIN
+    HANDLE handle;
+#elif PLT_LINUX
+    pthread_t handle;
+#endif
+} platform_thread;
+
+/* NOTE(abid): Hints for `platform_file_map`, ignored where the OS has no use for them. */
+typedef enum {
+    file_map_sequential = 1 << 0, // Read front to back once, read ahead more and drop pages behind.
+    file_map_hugepage = 1 << 1, // Back with huge pages where the file system allows it.
+    file_map_populate = 1 << 2, // Fault the whole file in up front instead of page by page.
+} file_map_flags;
+
+/* NOTE(abid): File opened for writing front to back, see `platform_file_create`. */
+typedef struct {
+#ifdef PLT_WIN
+    HANDLE handle;
+#elif PLT_LINUX
+    i32 handle;
+#endif
+} platform_file;
+
+/* NOTE(abid): Read-only view of a whole file, `data` is NULL for an empty file. */
+typedef struct {
+    char *data;
+    usize size;
+} platform_file_mapping;
+
+typedef struct {
+#ifdef PLT_WIN
+    HANDLE handle;
+#elif PLT_LINUX
+    sem_t handle;
+#endif
+} platform_semaphore;
+
+/* NOTE(abid): Use as `internal PLATFORM_THREAD_PROC(name) { ... }`, the argument is `param`. */
+#ifdef PLT_WIN
+#define PLATFORM_THREAD_PROC(name) DWORD WINAPI name(LPVOID param)
+#elif PLT_LINUX
+#define PLATFORM_THREAD_PROC(name) void *name(void *param)
+#endif
+typedef PLATFORM_THREAD_PROC(platform_thread_proc);
+
 #define UTILS_H
 #endif
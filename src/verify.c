@@ -0,0 +1,162 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 19:20:53 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+/* NOTE(abid): Checks computed distances against reference ones (the .f64 or a dataset's reference
+ * column, both mapped), across a thread pool. */
+#include "verify.h"
+
+/* NOTE(abid): Bits of `value` as an integer that orders the same way the floats do, so the ULP
+ * distance of two floats is the difference of theirs, across zero too. */
+inline internal u64
+verify_ordered_bits(f64 value) {
+    u64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : (bits | (1ULL << 63));
+}
+
+inline internal u64
+verify_ulp_distance(f64 a, f64 b) {
+    if(a != a || b != b) return ~0ULL;
+    u64 ordered_a = verify_ordered_bits(a), ordered_b = verify_ordered_bits(b);
+    return (ordered_a > ordered_b) ? ordered_a - ordered_b : ordered_b - ordered_a;
+}
+
+inline internal u32
+verify_ulp_bucket(u64 ulps) {
+    u32 bucket = 0;
+    while(ulps && bucket < VERIFY_ULP_BUCKET_COUNT - 1) {
+        ulps >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+/* NOTE(abid): Largest ULP distance first, the lowest index first among equal ones. */
+inline internal bool
+verify_offender_is_worse(verify_offender *a, verify_offender *b) {
+    return (a->ulps > b->ulps) || (a->ulps == b->ulps && a->idx < b->idx);
+}
+
+internal void
+verify_worst_insert(verify_result *result, verify_offender offender) {
+    u32 idx = result->worst_count;
+    if(idx == VERIFY_WORST_COUNT) {
+        if(!verify_offender_is_worse(&offender, result->worst + idx - 1)) return;
+        --idx;
+    } else ++result->worst_count;
+
+    for(; idx > 0 && verify_offender_is_worse(&offender, result->worst + idx - 1); --idx) {
+        result->worst[idx] = result->worst[idx - 1];
+    }
+    result->worst[idx] = offender;
+}
+
+/* NOTE(abid): Pairs `first` on of `distances` against the reference. */
+internal void
+verify_accumulate(verify_result *result, f64 *reference, f64 *distances, u64 first, u64 count) {
+    for(u64 idx = 0; idx < count; ++idx) {
+        f64 expected = reference[idx];
+        f64 computed = distances[idx];
+        u64 ulps = verify_ulp_distance(expected, computed);
+        ++result->ulp_histogram[verify_ulp_bucket(ulps)];
+        if(ulps == 0) continue;
+
+        u64 pair_idx = first + idx;
+        f64 abs_error = (ulps == ~0ULL) ? INFINITY : fabs(computed - expected);
+        f64 rel_error = (expected != 0.0) ? abs_error / fabs(expected) : INFINITY;
+        ++result->mismatch_count;
+        exact_sum_add(&result->abs_error_sum, abs_error);
+        /* NOTE(abid): A worker may run its chunks out of order (stolen ones), so ties go by index. */
+        if(abs_error > result->max_abs_error ||
+           (abs_error == result->max_abs_error && pair_idx < result->max_abs_idx)) {
+            result->max_abs_error = abs_error;
+            result->max_abs_idx = pair_idx;
+        }
+        if(rel_error > result->max_rel_error ||
+           (rel_error == result->max_rel_error && pair_idx < result->max_rel_idx)) {
+            result->max_rel_error = rel_error;
+            result->max_rel_idx = pair_idx;
+        }
+        if(result->worst_count < VERIFY_WORST_COUNT || ulps >= result->worst[VERIFY_WORST_COUNT - 1].ulps) {
+            verify_worst_insert(result, (verify_offender){ pair_idx, ulps, expected, computed });
+        }
+    }
+}
+
+/* NOTE(abid): Folds `src` into `dest`, workers may have seen chunks in any order so the maxima go
+ * by index on ties. */
+internal void
+verify_result_merge(verify_result *dest, verify_result *src) {
+    dest->pair_count += src->pair_count;
+    dest->mismatch_count += src->mismatch_count;
+    if(src->max_abs_error > dest->max_abs_error ||
+       (src->max_abs_error == dest->max_abs_error && src->max_abs_idx < dest->max_abs_idx)) {
+        dest->max_abs_error = src->max_abs_error;
+        dest->max_abs_idx = src->max_abs_idx;
+    }
+    if(src->max_rel_error > dest->max_rel_error ||
+       (src->max_rel_error == dest->max_rel_error && src->max_rel_idx < dest->max_rel_idx)) {
+        dest->max_rel_error = src->max_rel_error;
+        dest->max_rel_idx = src->max_rel_idx;
+    }
+    exact_sum_merge(&dest->abs_error_sum, &src->abs_error_sum);
+    for(u32 bucket = 0; bucket < VERIFY_ULP_BUCKET_COUNT; ++bucket) dest->ulp_histogram[bucket] += src->ulp_histogram[bucket];
+    for(u32 idx = 0; idx < src->worst_count; ++idx) verify_worst_insert(dest, src->worst[idx]);
+}
+
+internal void
+verify_job_fn(void *data, u64 first, u64 count, u32 worker_idx) {
+    verify_job *job = (verify_job *)data;
+    f64 *distances = job->distances + (u64)worker_idx*HAVERSINE_CHUNK_SIZE;
+    verify_result *result = job->worker_results + worker_idx;
+    /* NOTE(abid): One chunk per call (see `thread_job_fn`), so `distances` holds it. */
+    pair_soa chunk = pair_soa_slice(job->pairs, first, count);
+    __haversine_batch_impl(&chunk, distances, job->earth_radius, job->opt);
+    verify_accumulate(result, job->reference + first, distances, first, count);
+    result->pair_count += count;
+}
+
+/* NOTE(abid): Distances of `pairs` computed with the kernel (`.tier` as in `haversine_batch`) and
+ * compared against `reference` across `pool`, a chunk at a time, so no more than a chunk of
+ * distances per worker is ever kept. `reference` is read once, straight from wherever it is mapped,
+ * and has to hold `reference_count` values, one per pair. */
+#define verify_distances(pool, pairs, reference, reference_count, earth_radius, ...) \
+    __verify_distances_impl(pool, pairs, reference, reference_count, earth_radius, \
+                            (haversine_batch_opt){ haversine_batch_opt_default, __VA_ARGS__ })
+internal verify_result
+__verify_distances_impl(thread_pool *pool, pair_soa *pairs, f64 *reference, u64 reference_count,
+                        f64 earth_radius, haversine_batch_opt opt) {
+    bench_function_begin();
+    assert(reference_count == pairs->count, "%llu reference distances for %llu pairs.",
+           reference_count, pairs->count);
+    if(opt.tier == math_tier_count) opt.tier = kernel_math_tier_get();
+    /* NOTE(abid): Resolve the ISA before the workers race to do it. */
+    kernel_simd_level_get();
+
+    temp_memory temp = mem_temp_begin(pool->arena);
+    verify_job job = {
+        .pairs = pairs,
+        .reference = reference,
+        .earth_radius = earth_radius,
+        .opt = opt,
+        .distances = push_array_aligned(f64, (u64)pool->worker_count*HAVERSINE_CHUNK_SIZE, SIMD_ALIGNMENT, pool->arena),
+        .worker_results = push_array(verify_result, pool->worker_count, pool->arena),
+    };
+    for(u32 idx = 0; idx < pool->worker_count; ++idx) job.worker_results[idx] = (verify_result){0};
+
+    thread_pool_parallel_for(pool, pairs->count, HAVERSINE_CHUNK_SIZE, verify_job_fn, &job);
+
+    verify_result result = job.worker_results[0];
+    for(u32 idx = 1; idx < pool->worker_count; ++idx) verify_result_merge(&result, job.worker_results + idx);
+    mem_temp_end(temp);
+
+    return result;
+
+    bench_function_end();
+}
@@ -0,0 +1,49 @@
+/*  +======| File Info |===============================================================+
+    |                                                                                  |
+    |     Subdirectory:  /src                                                          |
+    |    Creation date:  So 18 Okt 2026 19:20:53 CEST                                  |
+    |    Last Modified:                                                                |
+    |                                                                                  |
+    +======================================| Copyright © Sayed Abid Hashimi |==========+  */
+
+#if !defined(VERIFY_H)
+
+/* NOTE(abid): ULP distance buckets, the first is exact matches, bucket `b` then holds distances in
+ * [2^(b-1), 2^b), and the last one everything from 2^(VERIFY_ULP_BUCKET_COUNT-2) up. */
+#define VERIFY_ULP_BUCKET_COUNT 12
+/* NOTE(abid): Pairs kept per run with the largest ULP distance. */
+#define VERIFY_WORST_COUNT 8
+
+typedef struct {
+    u64 idx;
+    u64 ulps; // All ones when either side is NaN.
+    f64 expected;
+    f64 computed;
+} verify_offender;
+
+/* NOTE(abid): Everything about a run is independent of the thread count: ties go to the lowest pair
+ * index, and the error sum is exact. */
+typedef struct {
+    u64 pair_count;
+    u64 mismatch_count; // Pairs not equal to the last bit.
+    f64 max_abs_error;
+    u64 max_abs_idx;
+    f64 max_rel_error; // Against the reference, infinite for a non-zero error against 0.
+    u64 max_rel_idx;
+    exact_sum abs_error_sum;
+    u64 ulp_histogram[VERIFY_ULP_BUCKET_COUNT];
+    verify_offender worst[VERIFY_WORST_COUNT]; // Largest ULP distance first.
+    u32 worst_count;
+} verify_result;
+
+typedef struct {
+    pair_soa *pairs;
+    f64 *reference;
+    f64 earth_radius;
+    haversine_batch_opt opt;
+    f64 *distances; // HAVERSINE_CHUNK_SIZE per worker.
+    verify_result *worker_results;
+} verify_job;
+
+#define VERIFY_H
+#endif